@@ -10,6 +10,7 @@
 # 	performance: distn
 # 	genotype: distn list of loci + corr
 # 	stoch: distn list of loci + corr + xcorr
+# 	var, hw: same statistics for replicate variances and half widths, -r only
 	 
 import os
 import sys
@@ -47,9 +48,7 @@ def close_files(infile, outfile):
 def read_runs(infile, outfile):
 	firstrun = True
 	param = {}
-	fdistn = {}
-	pdistn = {}
-	lowfit = {}
+	blocks = []
 	for line in infile:
 		fields = line.split()
 		# param group
@@ -57,68 +56,75 @@ def read_runs(infile, outfile):
 			print("{} {} {}".format(fields[0], fields[1], fields[2]))
 			group = 1
 			if not firstrun:
-				print_data(param,fdistn,lowfit,pdistn,gdistn,gcorr,sdistn,\
-					scorr,sgcorr,outfile,stoch,False)
+				blocks.append([name, b])
+				print_data(param,blocks,outfile,stoch,False)
 				param = {}
-				lowfit = {}
+				blocks = []
 				# reset all dicts
 			firstrun = False
 		if group == 1:
 			if not line.isspace():
 				param[fields[0]] = fields[2]
 			else:
-				group = 2
-				start = False
-				ptile = []
-				gdistn = []
-				sdistn = []
-				gtile = []
-				gcorr = []
-				scorr = []
-				sgcorr = []
 				loci = int(param["loci"])
 				stoch = True if float(param["stochWt"]) > 1e-6 else False
-				for i in range(loci):
-					gdistn.append({})
-					sdistn.append({})
-					gtile.append([])
+				[group,start,ptile,gtile,name,b] = new_block(loci, "")
 			continue
 		# fitness distn group
 		if group == 2:
-			[group,start,ptile] = set_distn(fdistn,ptile,lowfit,line,start,group,1)
+			[group,start,ptile] = set_distn(b["fdistn"],ptile,b["lowfit"],line,start,group,1)
 			continue
 		# performance distn group
 		if group == 3:
-			[group,start,ptile] = set_distn(pdistn,ptile,lowfit,line,start,group,1)
+			[group,start,ptile] = set_distn(b["pdistn"],ptile,b["lowfit"],line,start,group,1)
 			continue
 		# genotype distn group
 		if group == 4:
 			for i in range(loci):
 				[group,start,gtile[i]] = \
-					set_distn(gdistn[i],gtile[i],lowfit,line,start,group,i+1,loci)
+					set_distn(b["gdistn"][i],gtile[i],b["lowfit"],line,start,group,i+1,loci)
 			if group > 4: group = 5
 			continue
 		# genotype corr group
 		if group == 5:
-			[group,start] = set_corr(gcorr,line,start,group,loci)
+			[group,start] = set_corr(b["gcorr"],line,start,group,loci)
+			if group == 6 and not stoch: group = 9
 			continue
 		# stoch genotype distn group
 		if group == 6:
 			for i in range(loci):
 				[group,start,gtile[i]] = \
-					set_distn(sdistn[i],gtile[i],lowfit,line,start,group,i+1,loci)
+					set_distn(b["sdistn"][i],gtile[i],b["lowfit"],line,start,group,i+1,loci)
 			if group > 6: group = 7
 			continue
 		# stochastic corr group
 		if group == 7:
-			[group,start] = set_corr(scorr,line,start,group,loci)
+			[group,start] = set_corr(b["scorr"],line,start,group,loci)
 			continue
 		# stochastic X genotype corr group
 		if group == 8:
-			[group,start] = set_corr(sgcorr,line,start,group,loci)
+			[group,start] = set_corr(b["sgcorr"],line,start,group,loci)
 			continue
+		# group 9: analyses after statistics, robust, freqResp, stepBands, selGrad, not read,
+		# except replicate variances and half widths of -r, in the layout of the statistics
+		if group == 9 and not line.isspace() and fields[0] == "Replicate":
+			blocks.append([name, b])
+			[group,start,ptile,gtile,name,b] = \
+				new_block(loci, "var" if fields[1] == "variances" else "hw")
 			
-	print_data(param,fdistn,lowfit,pdistn,gdistn,gcorr,sdistn,scorr,sgcorr,outfile,stoch,True)
+	blocks.append([name, b])
+	print_data(param,blocks,outfile,stoch,True)
+
+# statistics of one block: a run, or mean, variance or half width of replicates
+def new_block(loci, name):
+	b = {"fdistn": {}, "lowfit": {}, "pdistn": {}, "gdistn": [], "gcorr": [],
+		"sdistn": [], "scorr": [], "sgcorr": []}
+	gtile = []
+	for i in range(loci):
+		b["gdistn"].append({})
+		b["sdistn"].append({})
+		gtile.append([])
+	return [2, False, [], gtile, name, b]
 
 def set_distn(distn, ptile, lowfit, line, start, group, field_num, field_max=1):
 	fields = line.split()
@@ -189,26 +195,34 @@ def print_corr(corr, name, outfile):
 	outfile.write("{}".format(corr).replace("[", "{").replace("]", "}").replace("'",""))
 	outfile.write("|>")
 
-def print_data(param,fdistn,lowfit,pdistn,gdistn,gcorr,sdistn,scorr,sgcorr,outfile,stoch,last):
-	outfile.write("<|")
-	print_param(param, outfile)
-	print_distn(fdistn, "fdistn", outfile)
+def print_stats(b, outfile, stoch):
+	print_distn(b["fdistn"], "fdistn", outfile)
 	outfile.write(",")
-	if len(lowfit) > 0:
-		print_lowfit(lowfit, outfile)
+	if len(b["lowfit"]) > 0:
+		print_lowfit(b["lowfit"], outfile)
 		outfile.write(",")
-	print_distn(pdistn, "pdistn", outfile)
+	print_distn(b["pdistn"], "pdistn", outfile)
 	outfile.write(",")
-	print_gdistn(gdistn, "gdistn", outfile)
+	print_gdistn(b["gdistn"], "gdistn", outfile)
 	outfile.write(",")
-	print_corr(gcorr, "gcorr", outfile)
+	print_corr(b["gcorr"], "gcorr", outfile)
 	if stoch:
 		outfile.write(",")
-		print_gdistn(sdistn, "sdistn", outfile)		
+		print_gdistn(b["sdistn"], "sdistn", outfile)		
 		outfile.write(",")
-		print_corr(scorr, "scorr", outfile)		
+		print_corr(b["scorr"], "scorr", outfile)		
 		outfile.write(",")
-		print_corr(sgcorr, "sgcorr", outfile)		
+		print_corr(b["sgcorr"], "sgcorr", outfile)		
+
+# first block is run or replicate mean, later blocks "var" and "hw" of replicates
+def print_data(param,blocks,outfile,stoch,last):
+	outfile.write("<|")
+	print_param(param, outfile)
+	print_stats(blocks[0][1], outfile, stoch)
+	for [name, b] in blocks[1:]:
+		outfile.write(",<|\"{}\" -> <|".format(name))
+		print_stats(b, outfile, stoch)
+		outfile.write("|>|>")
 	outfile.write("|>")
 	if not last:
 		outfile.write(",")
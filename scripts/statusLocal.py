@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+
+# Show status of sensitivity processes on this host from shared memory blocks written by src/Status.cc, no ssh or log files needed.
+# statusLocal.py [-w secs] [-c], -w repeats every secs, -c removes blocks left by processes that died
+
+import argparse
+import glob
+import os
+import struct
+import time
+
+# layout of StatusData in src/Status.h, version 1
+fmt = '<QQQq64s' + 'qqqqqq' + 'QQQ' + 'QQQ' + 'q' + '4Q'
+size = struct.calcsize(fmt)
+magicNumber = 0x54415453534e4553
+versionNumber = 1
+phases = ['init', 'evolve', 'stats', 'write']
+
+parser = argparse.ArgumentParser(description='Show status of sensitivity processes on this host.')
+parser.add_argument("-w", "--watch", type=float, help="repeat every WATCH seconds")
+parser.add_argument("-c", "--clean", action='store_true', help="remove status of dead processes")
+args = parser.parse_args()
+
+def alive(pid):
+	try:
+		os.kill(pid, 0)
+	except ProcessLookupError:
+		return False
+	except PermissionError:
+		pass
+	return True
+
+# seqlock: copy block, accept only if seq even and unchanged
+def readBlock(path):
+	with open(path, 'rb') as f:
+		for tries in range(100):
+			f.seek(0)
+			buf = f.read(size)
+			if len(buf) < size:
+				return None
+			v = struct.unpack(fmt, buf)
+			if v[0] != magicNumber:
+				return None
+			f.seek(16)
+			seq = struct.unpack('<Q', f.read(8))[0]
+			if v[2] % 2 == 0 and seq == v[2]:
+				break
+			time.sleep(0.001)
+		else:
+			return None
+	keys = ['magic', 'version', 'seq', 'pid', 'tag', 'firstRun', 'lastRun', 'runNum', 'runsDone',
+		'gen', 'totalGen', 'evals', 'tblLookups', 'tblMisses', 'startNs', 'runStartNs', 'updateNs', 'phase']
+	d = dict(zip(keys, v[:18]))
+	d['phaseNs'] = v[18:22]
+	d['tag'] = d['tag'].split(b'\0')[0].decode('utf-8', 'replace')
+	return d if d['version'] == versionNumber else None
+
+def fmtTime(s):
+	s = int(s)
+	return '{}:{:02}:{:02}'.format(s // 3600, (s // 60) % 60, s % 60)
+
+def show():
+	blocks = []
+	for path in sorted(glob.glob('/dev/shm/sensitivity.status.*') + glob.glob('/tmp/sensitivity.status.*')):
+		try:
+			d = readBlock(path)
+		except OSError:
+			continue
+		if d is None:
+			continue
+		if not alive(d['pid']):
+			if args.clean:
+				os.remove(path)
+			else:
+				print('{:>8} dead, status left in {}, remove with -c'.format(d['pid'], path))
+			continue
+		blocks.append(d)
+	now = time.time_ns()
+	print('{:>8} {:<20} {:>13} {:>15} {:>10} {:>7} {:>22} {:>10}'.format(
+		'pid', 'tag', 'run', 'gen', 'evals/s', 'tblHit', 'init/evol/stat/write %', 'eta'))
+	totalRate = 0.0
+	for d in blocks:
+		elapsed = max(1e-9, (now - d['startNs']) * 1e-9)
+		rate = d['evals'] / elapsed
+		totalRate += rate
+		hit = '-' if d['tblLookups'] == 0 else '{:.1f}%'.format(100.0 * (1 - d['tblMisses'] / d['tblLookups']))
+		ph = sum(d['phaseNs'])
+		phaseStr = '/'.join('{:.0f}'.format(100.0 * p / ph) if ph else '0' for p in d['phaseNs'])
+		# completed runs plus fraction of current run give mean time per run
+		frac = d['gen'] / d['totalGen'] if d['totalGen'] > 0 else 0.0
+		done = d['runsDone'] + (frac if d['runsDone'] < d['lastRun'] - d['firstRun'] + 1 else 0.0)
+		left = d['lastRun'] - d['firstRun'] + 1 - done
+		eta = fmtTime(elapsed / done * left) if done > 0 else '-'
+		print('{:>8} {:<20} {:>6}/{:<6} {:>7}/{:<7} {:>10.0f} {:>7} {:>22} {:>10}'.format(
+			d['pid'], d['tag'][:20], d['runNum'], d['lastRun'], d['gen'], d['totalGen'],
+			rate, hit, phaseStr + ' ' + phases[d['phase']], eta))
+	print('{} processes, {:.0f} evals/s total'.format(len(blocks), totalRate))
+
+while True:
+	show()
+	if args.watch is None:
+		break
+	time.sleep(args.watch)
+	print()
@@ -0,0 +1,53 @@
+#include <cmath>
+
+#include "Aggregate.h"
+
+// Upper 97.5% point of Student t: table for df <= 30, else Cornish-Fisher expansion in 1/df about the normal point, error < 0.002
+
+double TQuantile975(int df)
+{
+    const double t[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df <= 30) return t[df - 1];
+    const double z = 1.959964;
+    double z3 = z*z*z, z5 = z3*z*z, v = static_cast<double>(df);
+    return z + (z3 + z)/(4.0*v) + (5.0*z5 + 16.0*z3 + 3.0*z)/(96.0*v*v);
+}
+
+void Aggregate::add(const std::vector<double>& x)
+{
+    if (n == 0){
+        mean.assign(x.size(), 0.0);
+        m2.assign(x.size(), 0.0);
+    }
+    else if (x.size() != mean.size())
+        ThrowError(__FILE__, __LINE__, "Aggregate: replicates have different numbers of statistics");
+    ++n;
+    for (size_t k = 0; k < x.size(); ++k){
+        double d = x[k] - mean[k];
+        mean[k] += d/n;
+        m2[k] += d*(x[k] - mean[k]);
+    }
+}
+
+double Aggregate::halfWidth(size_t k)
+{
+    if (n < 2) return -1.0;
+    return TQuantile975(n - 1)*sqrt(m2[k]/(n - 1)/n);
+}
+
+std::vector<double> Aggregate::variances()
+{
+    std::vector<double> v(mean.size(), -1.0);
+    if (n < 2) return v;
+    for (size_t k = 0; k < v.size(); ++k) v[k] = m2[k]/(n - 1);
+    return v;
+}
+
+std::vector<double> Aggregate::halfWidths()
+{
+    std::vector<double> h(mean.size());
+    for (size_t k = 0; k < h.size(); ++k) h[k] = halfWidth(k);
+    return h;
+}
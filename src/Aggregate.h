@@ -0,0 +1,25 @@
+#ifndef _Aggregate_h
+#define _Aggregate_h 1
+
+#include <vector>
+
+#include APPL_H
+
+// Replicate aggregation. Runs whose lines match except for runNum, token 0, are replicates of one design point. Statistics of each replicate, SumStat::toVector, are accumulated by Welford's update field by field, so memory does not grow with replicates. When all replicates of a point in the run range are done, or the 95% confidence half width of mean aveFitness reaches a target, one summary for the point, with mean, variance and half width of each field, replaces the per replicate summaries, see PrintAggregate; remaining replicates of a stopped point are skipped.
+
+class Aggregate
+{
+public:
+    void        add(const std::vector<double>& x);
+    int         getN(){return n;}
+    auto&       getMean(){return mean;}
+    double      halfWidth(size_t k);                // 95% confidence half width of mean of field k, -1 if n < 2
+    std::vector<double> variances();                // sample variance among replicates of each field, -1 if n < 2
+    std::vector<double> halfWidths();
+private:
+    int         n = 0;
+    std::vector<double> mean;
+    std::vector<double> m2;                         // sum of squared deviations from mean
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include <cmath>
+#include <algorithm>
+
+#include "ClonePopulation.h"
+#include "Evaluate.h"
+
+int RandomBinomial(int n, double p, SAFrand_pcg<pcgT>& r);
+
+ClonePopulation::ClonePopulation(Param& param)
+{
+    popSize = param.popsize;
+    loci = param.loci;
+    recombine = (param.recombination >= 1e-7);      // same threshold as Population
+}
+
+void ClonePopulation::compress(Population& pop)
+{
+    SetBaby = pop.getSetBaby();
+    next.clear();
+    index.clear();
+    for (auto& ind : pop.getIndividuals())
+        add(ind, ind.getFitness(), 1, ind.getFitness(), true);
+    classes.swap(next);
+}
+
+void ClonePopulation::expand(Population& pop)
+{
+    auto& v = pop.getIndividuals();
+    size_t n = 0;
+    for (auto& c : classes){
+        for (int k = 0; k < c.count; ++k)
+            v[n++] = c.ind;
+    }
+    pop.setFitnessArray();
+}
+
+// key is genotype and weight, so merged offspring are selected alike
+
+void ClonePopulation::add(const Individual& ind, double weight, int count, double own, bool known)
+{
+    auto& g = const_cast<Individual&>(ind).getGenotype();
+    key.assign(reinterpret_cast<const char *>(g.get()), static_cast<size_t>(loci)*sizeof(Allele));
+    key.append(reinterpret_cast<const char *>(&weight), sizeof(weight));
+    auto it = index.find(key);
+    if (it != index.end()){
+        next[it->second].count += count;
+        return;
+    }
+    index.emplace(key, next.size());
+    next.push_back({ind, count, own, known});
+    next.back().ind.setFitness(weight);
+}
+
+// calcFitness overwrites stored fitness, so keep weight
+
+double ClonePopulation::ownFitness(Clone& c)
+{
+    if (!c.known){
+        double w = c.ind.getFitness();
+        c.own = c.ind.calcFitness();
+        c.ind.setFitness(w);
+        c.known = true;
+    }
+    return c.own;
+}
+
+void ClonePopulation::reproduce()
+{
+    auto C = classes.size();
+    std::vector<double> cum(C + 1, 0.0);
+    for (size_t i = 0; i < C; ++i)
+        cum[i+1] = cum[i] + classes[i].count*classes[i].ind.getFitness();
+    if (!(cum[C] > 0.0)){           // no fitness anywhere, choose individuals uniformly
+        for (size_t i = 0; i < C; ++i)
+            cum[i+1] = cum[i] + classes[i].count;
+    }
+    double W = cum[C];
+    size_t lastPos = C - 1;         // last class with weight takes remaining offspring, no rounding loss
+    while (lastPos > 0 && !(cum[lastPos+1] > cum[lastPos])) --lastPos;
+    double pMut = Individual::probMutation();
+    auto& select = *rndStreams.select;
+    auto& vary = *rndStreams.vary;
+    next.clear();
+    index.clear();
+    Individual baby;
+    baby.allocate();
+    int left = popSize;
+    double mass = W;
+    for (size_t i = 0; i < C && left > 0; ++i){
+        double w = cum[i+1] - cum[i];
+        int k = (i == lastPos) ? left : RandomBinomial(left, w/mass, select);
+        left -= k;
+        mass -= w;
+        if (k == 0) continue;
+        auto& c = classes[i];
+        double own = ownFitness(c);
+        int same = (recombine) ? RandomBinomial(k, w/W, select) : k;
+        int mutants = RandomBinomial(same, pMut, vary);
+        if (same > mutants) add(c.ind, own, same - mutants, own, true);
+        for (int m = 0; m < mutants; ++m){
+            baby = c.ind;
+            baby.mutateForced();
+            add(baby, own, 1, 0.0, false);
+        }
+        for (int r = same; r < k; ++r){
+            // second parent from classes other than i
+            double u = select.rU01()*(W - w);
+            if (u >= cum[i]) u += w;
+            auto j = static_cast<size_t>(std::upper_bound(cum.begin() + 1, cum.end(), u) - (cum.begin() + 1));
+            j = std::min(j, C - 1);
+            SetBaby(c.ind, classes[j].ind, baby);
+            double f = baby.getFitness();
+            if (vary.rU01() < pMut){
+                baby.mutateForced();
+                add(baby, f, 1, 0.0, false);
+            }
+            else
+                add(baby, f, 1, f, true);
+        }
+    }
+    classes.swap(next);
+}
+
+void ClonePopulation::recalcFitness()
+{
+    next.clear();
+    index.clear();
+    for (auto& c : classes){
+        double f = c.ind.calcFitness();
+        add(c.ind, f, c.count, f, true);
+    }
+    classes.swap(next);
+}
+
+void ClonePopulation::clearFitness()
+{
+    for (auto& c : classes) c.known = false;
+}
+
+// As Population::genStats, weighted by counts; weight of class is the stored fitness that sets selection
+
+GenStats ClonePopulation::genStats(bool alleles)
+{
+    GenStats s;
+    double n = popSize;
+    double sum = 0.0, ss = 0.0;
+    for (auto& c : classes) sum += c.count*c.ind.getFitness();
+    s.fitMean = sum/n;
+    for (auto& c : classes){
+        double d = c.ind.getFitness() - s.fitMean;
+        ss += c.count*d*d;
+    }
+    s.fitSD = sqrt(ss/n);
+    if (!alleles || classes.empty()) return s;
+    auto L = static_cast<size_t>(loci);
+    const Allele *g0 = classes[0].ind.getGenotype().get();
+    std::vector<double> d(L, 0.0), dd(L, 0.0);
+    for (auto& c : classes){
+        const Allele *g = c.ind.getGenotype().get();
+        for (size_t j = 0; j < L; ++j){
+            double x = g[j] - g0[j];
+            d[j] += c.count*x;
+            dd[j] += c.count*x*x;
+        }
+    }
+    for (size_t j = 0; j < L; ++j) s.gVar += dd[j]/n - (d[j]/n)*(d[j]/n);
+    s.gVar /= static_cast<double>(L);
+    return s;
+}
+
+// As Population::fidelityChange, weighted by counts. Fitness is deterministic, so no random streams needed.
+
+double ClonePopulation::fidelityChange(const Fidelity& lo, const Fidelity& hi)
+{
+    auto& p = Individual::getEvalParam();
+    SAFrand_pcg<pcgT> r;
+    auto C = classes.size();
+    std::vector<double> w[2];
+    double sum[2] = {0.0, 0.0};
+    auto saved = getFidelity();
+    for (int f = 0; f < 2; ++f){
+        setFidelity((f == 0) ? lo : hi);
+        w[f].resize(C);
+        for (size_t i = 0; i < C; ++i){
+            w[f][i] = EvalFitness(EvalJ(classes[i].ind.getGenotype().get(), nullptr, p, r), p);
+            sum[f] += classes[i].count*w[f][i];
+        }
+    }
+    setFidelity(saved);
+    if (sum[0] <= 0.0 || sum[1] <= 0.0) return (sum[0] == sum[1]) ? 0.0 : 1.0;
+    double tv = 0.0;
+    for (size_t i = 0; i < C; ++i)
+        tv += classes[i].count*std::abs(w[0][i]/sum[0] - w[1][i]/sum[1]);
+    return 0.5*tv;
+}
+
+// Binomial by inversion. For small mean, sum probabilities up from zero; else start at mode and step alternately down and up, cost O(sd). Probabilities by ratio recurrence from exact mode probability.
+
+int RandomBinomial(int n, double p, SAFrand_pcg<pcgT>& r)
+{
+    if (n <= 0 || p <= 0.0) return 0;
+    if (p >= 1.0) return n;
+    if (p > 0.5) return n - RandomBinomial(n, 1.0 - p, r);
+    double q = 1.0 - p;
+    double ratio = p/q;
+    double u = r.rU01();
+    if (n*p < 30.0){
+        double pk = exp(n*log1p(-p));
+        int k = 0;
+        u -= pk;
+        while (u > 0.0 && k < n){
+            pk *= ratio*(n - k)/(k + 1);
+            ++k;
+            u -= pk;
+        }
+        return k;
+    }
+    int m = static_cast<int>((n + 1)*p);
+    double pm = exp(lgamma(n + 1.0) - lgamma(m + 1.0) - lgamma(n - m + 1.0) + m*log(p) + (n - m)*log1p(-p));
+    u -= pm;
+    if (u <= 0.0) return m;
+    int lo = m, hi = m;
+    double plo = pm, phi = pm;
+    while (lo > 0 || hi < n){
+        if (lo > 0){
+            plo *= lo/(ratio*(n - lo + 1));
+            --lo;
+            if ((u -= plo) <= 0.0) return lo;
+        }
+        if (hi < n){
+            phi *= ratio*(n - hi)/(hi + 1);
+            ++hi;
+            if ((u -= phi) <= 0.0) return hi;
+        }
+    }
+    return m;
+}
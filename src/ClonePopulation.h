@@ -0,0 +1,50 @@
+#ifndef _ClonePopulation_h
+#define _ClonePopulation_h 1
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Individual.h"
+#include "Population.h"
+#include "Performance.h"
+
+// Population as clone classes, each a distinct genotype with a count, so a generation costs O(classes) instead of O(popsize) fitness evaluations. Used when fitness of a genotype is deterministic, aSD == 0 and stochWt == 0, and there is no genealogy; see param clones.
+
+// Same life cycle as Population::reproduceMutateCalcFit in distribution. Offspring counts of classes are multinomial with probabilities count * weight, weight is stored fitness of class as in Population, drawn as sequential binomials. Without recombination, offspring copy their class, Binomial(k, probMutation()) of them mutate and form new classes. With recombination, second parent is from same class with probability of that class, baby then identical to parent; else second parent drawn from other classes by cumulative weights and baby is a new class. As in Population, fitness is calculated before mutation, so weight of a mutant is fitness of its unmutated genotype, and fitness of its own genotype is calculated once, when the class first has offspring. Offspring with same genotype and weight are merged.
+
+class ClonePopulation
+{
+public:
+    explicit ClonePopulation(Param& param);
+    void        compress(Population& pop);          // classes from individuals of pop, stored fitness of pop current
+    void        expand(Population& pop);            // individuals and fitness array of pop from classes
+    void        reproduce();                        // one generation
+    void        recalcFitness();                    // as Population::recalcFitness
+    void        clearFitness();                     // genotype fitness stale after fidelity change, recalculate when used
+    double      fidelityChange(const Fidelity& lo, const Fidelity& hi);
+    GenStats    genStats(bool alleles);             // as Population::genStats, weighted by counts
+    size_t      getClasses(){return classes.size();}
+private:
+    struct Clone {
+        Individual  ind;        // fitness of ind is weight
+        int         count;
+        double      own;        // fitness of genotype, valid if known
+        bool        known;
+    };
+    double      ownFitness(Clone& c);
+    void        add(const Individual& ind, double weight, int count, double own, bool known);
+    int         popSize;
+    int         loci;
+    bool        recombine;
+    void        (*SetBaby)(Individual&, Individual&, Individual&) = nullptr;
+    std::vector<Clone>  classes;
+    std::vector<Clone>  next;               // classes of next generation, merged through index
+    std::unordered_map<std::string, size_t> index;
+    std::string key;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include <cmath>
+#include <algorithm>
+
+#include "Equilibrium.h"
+
+bool Equilibrium::add(const GenStats& s)
+{
+    const double x[stats] = {s.fitMean, s.fitSD, s.gVar};
+    int b = n*batches/window;
+    for (int k = 0; k < stats; ++k) sum[k][b] += x[k];
+    ++count[b];
+    if (++n < window) return false;
+    bool stationary = (blocks > 0);
+    for (int k = 0; k < stats; ++k){
+        // block mean as mean of batch means, SE from their spread
+        double bm[batches], mean = 0.0, ss = 0.0;
+        int used = 0;
+        for (int j = 0; j < batches; ++j){
+            if (count[j] == 0) continue;
+            bm[used] = sum[k][j]/count[j];
+            mean += bm[used++];
+        }
+        mean /= used;
+        for (int j = 0; j < used; ++j) ss += (bm[j] - mean)*(bm[j] - mean);
+        double se = (used > 1) ? sqrt(ss/(used - 1)/used) : 0.0;
+        double allowed = tol*std::max(std::abs(mean), std::abs(last[k])) + 2.0*sqrt(se*se + lastSE[k]*lastSE[k]) + 1e-12;
+        if (std::abs(mean - last[k]) > allowed) stationary = false;
+        last[k] = mean;
+        lastSE[k] = se;
+        for (auto& y : sum[k]) y = 0.0;
+    }
+    for (auto& c : count) c = 0;
+    n = 0;
+    ++blocks;
+    agree = (stationary) ? agree + 1 : 0;
+    return agree >= 2;
+}
+
+bool Equilibrium::degenerate(const GenStats& s)
+{
+    return !(s.fitMean > 0.0) || !std::isfinite(s.fitMean);
+}
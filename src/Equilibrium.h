@@ -0,0 +1,38 @@
+#ifndef _Equilibrium_h
+#define _Equilibrium_h 1
+
+#include APPL_H
+
+// Statistics of one generation: mean and SD of stored fitness, which sets selection, and mean over loci of variance of genotype alleles among individuals. gVar only when asked, see Population::genStats.
+
+struct GenStats {
+    double fitMean = 0.0;
+    double fitSD = 0.0;
+    double gVar = 0.0;
+};
+
+// Convergence monitor for LifeCycle, param eqWindow > 0. Generations are grouped into blocks of eqWindow, each split into batches equal in length; block mean and its standard error from the spread of batch means, which are nearly independent if a batch is longer than the time over which drift correlates the statistic. Running sums only, so a generation costs O(1) beyond its statistics. Stationary when, for two successive pairs of complete blocks, so over three blocks, means of each statistic differ by at most eqTol times the larger magnitude plus 2 combined standard errors, plus 1e-12 for statistics near zero. Fitness SD and gVar of small populations change between blocks by tens of percent from drift and rare deleterious mutants, so batches must outlast drift, a window of several popsize, and eqTol of about 0.1; a trend over the blocks moves the means by more than the spread of batches within a block and keeps the run going.
+
+// Degenerate population: mean fitness not > 0 or not finite, so selection probabilities are undefined. Checked every generation whether or not the monitor is on.
+
+class Equilibrium
+{
+public:
+    Equilibrium(int w, double t) : window(w), tol(t) {}
+    bool        add(const GenStats& s);         // true when stationary
+    static bool degenerate(const GenStats& s);
+private:
+    static const int stats = 3;
+    static const int batches = 5;
+    int         window;
+    double      tol;
+    int         n = 0;                          // generations in current block
+    int         blocks = 0;                     // complete blocks
+    int         agree = 0;                      // successive comparisons within tolerance
+    double      sum[stats][batches] = {};       // sums by batch of current block
+    int         count[batches] = {};
+    double      last[stats] = {};               // mean of last complete block
+    double      lastSE[stats] = {};             // and its standard error
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Evaluate.h"
+#include "Performance.h"
+
+template <class T>
+void TransferPolys(const std::vector<T>& x, const EvalParam& p, const std::vector<T>& plantDen,
+                   std::vector<T>& num, std::vector<T>& den);
+
+int EvalLoci(Loop loop, int ctrlOrder)
+{
+    return 2*ctrlOrder + ((loop == Loop::dclose) ? 3 : 1);
+}
+
+EvalParam EvalNominal(const EvalParam& p)
+{
+    EvalParam det = p;
+    det.aSD = 0.0;
+    det.stochWt = 0.0;
+    det.stoch = false;
+    return det;
+}
+
+bool EvalStoch(double stochWt)
+{
+    return std::abs(stochWt) >= 1e-6;
+}
+
+int EvalStateDim(const EvalParam& p)
+{
+    return p.ctrlOrder - 1 + p.plantOrder + ((p.loop == Loop::dclose) ? 1 : 0);
+}
+
+// plant denominator 1 + a s + s^2, times (1 + s) for each order above 2. Order >= 2 keeps num of lower degree than den, as step response output and H2 need.
+
+std::vector<double> PlantDen(double a, int order)
+{
+    std::vector<double> d = {1.0, a, 1.0};
+    for (int i = 2; i < order; ++i) d = PolyMul(d, {1.0, 1.0});
+    return d;
+}
+
+template <class T>
+std::vector<T> PolyMul(const std::vector<T>& x, const std::vector<T>& y)
+{
+    std::vector<T> z(x.size() + y.size() - 1, 0.0);
+    for (size_t i = 0; i < x.size(); ++i)
+        for (size_t j = 0; j < y.size(); ++j)
+            z[i+j] += x[i]*y[j];
+    return z;
+}
+
+template <class T>
+std::vector<T> PolyAdd(const std::vector<T>& x, const std::vector<T>& y)
+{
+    std::vector<T> z(std::max(x.size(), y.size()), 0.0);
+    for (size_t i = 0; i < x.size(); ++i) z[i] += x[i];
+    for (size_t i = 0; i < y.size(); ++i) z[i] += y[i];
+    return z;
+}
+
+template std::vector<double> PolyMul(const std::vector<double>& x, const std::vector<double>& y);
+template std::vector<Jet> PolyMul(const std::vector<Jet>& x, const std::vector<Jet>& y);
+template std::vector<double> PolyAdd(const std::vector<double>& x, const std::vector<double>& y);
+template std::vector<Jet> PolyAdd(const std::vector<Jet>& x, const std::vector<Jet>& y);
+
+// Calculation of num and den take from openVclose.h in pagmo optimization code; assumes dentilde = den, ie, not studying role of variable plant w/regard to stability margin. Plant set, see manuscripts. Plant parameters do not vary, thus a is set to optimal value of a = sqrt(1 + gamma), and optimal value of J = sqrt(gamma).
+// Forms for num and den in MMA file
+// Order of random draws must not change, simulation results depend on it.
+
+double EvalTransfer(const Allele *genotype, const Allele *stochast, const EvalParam& p, SAFrand_pcg<pcgT>& r,
+                    std::vector<double>& num, std::vector<double>& den)
+{
+    double a = sqrt(1+p.gamma);
+    bool stoch = p.stoch;
+    double stochWt = p.stochWt;
+    if (std::abs(p.aSD) > 1e-6) a *= pow(2.0,r.normal(0,p.aSD));   // a = a*2^x, x ~ N(0,aSD)
+    if (p.ctrlOrder != 2 || p.plantOrder != 2){
+        EvalTransferOrder(genotype, stochast, p, r, a, num, den);
+        return a;
+    }
+    // p0 = 0 by assumption
+    double p1 = genotype[0] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[0])) : 1.0);
+    double p2 = genotype[1] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[1])) : 1.0);
+    double q0 = genotype[2] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[2])) : 1.0);
+    double q1 = genotype[3] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[3])) : 1.0);
+    double q2 = genotype[4] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[4])) : 1.0);
+    double rr = 0.0, k = 0.0;
+    if (p.loop == Loop::dclose){
+        rr = genotype[5] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[5])) : 1.0);
+        k = genotype[6] * ((stoch) ? pow(2.0,r.normal(0,stochWt*stochast[6])) : 1.0);
+    }
+    switch (p.loop){
+        case Loop::open:
+            num = {q2,q1,q0};
+            den = {p2, p1+a*p2, a*p1 + p2, p1};
+            break;
+        case Loop::close:
+            num = {q2,q1,q0};
+            den = {p2+q2, p1+a*p2+q1, a*p1+p2+q0, p1};
+            break;
+        case Loop::dclose:
+            double rk = rr*k;
+            num = {rk*q2, rk*q1 + k*q2, rk*q0 + k*q1, k*q0};
+            den = {rk*q2, p2 + rk*q1 + q2 + k*q2, p1 + a*p2 + rk*q0 + q1 + k*q1,
+                a*p1 + p2 + q0 + k*q0, p1};
+            break;
+    }
+    return a;
+}
+
+// Generic orders: controller C = q/pt, q of degree ctrlOrder, pt of degree ctrlOrder - 1, with alleles in the order of the original model, pt high to low order then q high to low order, then r, k for dclose; plant P = 1/PlantDen. Reduces to the forms above for orders 2, 2.
+//   open:   num = q,            den = pt Pd
+//   close:  num = q,            den = pt Pd + q
+//   dclose: num = q k (r + s),  den = s pt Pd + q (r k + (1 + k) s)
+// Phenotypic values drawn locus by locus as above.
+
+void EvalTransferOrder(const Allele *genotype, const Allele *stochast, const EvalParam& p, SAFrand_pcg<pcgT>& r,
+                       double a, std::vector<double>& num, std::vector<double>& den)
+{
+    auto L = static_cast<size_t>(EvalLoci(p.loop, p.ctrlOrder));
+    std::vector<double> x(L);
+    for (size_t i = 0; i < L; ++i)
+        x[i] = genotype[i] * ((p.stoch) ? pow(2.0,r.normal(0,p.stochWt*stochast[i])) : 1.0);
+    TransferPolys(x, p, PlantDen(a, p.plantOrder), num, den);
+}
+
+// num and den from phenotypic values x of loci, as above; over Jets for EvalJet
+
+template <class T>
+void TransferPolys(const std::vector<T>& x, const EvalParam& p, const std::vector<T>& plantDen,
+                   std::vector<T>& num, std::vector<T>& den)
+{
+    auto m = static_cast<size_t>(p.ctrlOrder);
+    std::vector<T> pt(m), q(m + 1);
+    for (size_t j = 0; j < m; ++j) pt[j] = x[m - 1 - j];
+    for (size_t j = 0; j <= m; ++j) q[j] = x[2*m - j];
+    std::vector<T> ptPd = PolyMul(pt, plantDen);
+    switch (p.loop){
+        case Loop::open:
+            num = q;
+            den = ptPd;
+            break;
+        case Loop::close:
+            num = q;
+            den = PolyAdd(ptPd, q);
+            break;
+        case Loop::dclose:
+            T rr = x[2*m + 1], k = x[2*m + 2];
+            num = PolyMul(q, {rr*k, k});
+            den = PolyAdd(PolyMul({0.0, 1.0}, ptPd), PolyMul(q, {rr*k, 1.0 + k}));
+            break;
+    }
+}
+
+double EvalJ(const Allele *genotype, const Allele *stochast, const EvalParam& p, SAFrand_pcg<pcgT>& r)
+{
+    double tmax = 20.0;
+    std::vector<double> num;
+    std::vector<double> den;
+    double a = EvalTransfer(genotype, stochast, p, r, num, den);
+    // output from all of num for generic orders, see Performance.h
+    unsigned long outTerms = (p.ctrlOrder != 2 || p.plantOrder != 2) ? num.size() : 3;
+
+    if (p.ctrlWt == 0.0)
+        return performance(num, den, p.gamma, tmax, signalType::output, outTerms);
+    // output y = P u with plant P = 1/Pd, so control signal u = num Pd / den
+    std::vector<double> ctrlNum = CtrlNumerator(num, den, PlantDen(a, p.plantOrder));
+    return performance(num, ctrlNum, den, p.gamma, tmax,
+                       (p.loop == Loop::open) ? signalType::controlOpen : signalType::controlClosed, p.ctrlWt,
+                       outTerms);
+}
+
+// num Pd has degree one more than den. Quotient Q1 s + Q0 plus remainder R / den: the Q1 s term is a Dirac impulse at the step, which has no finite squared error and is dropped, as H2sq drops the impulse of equal sized num and den. Returned numerator Q0 den + R is same size as den, as stepPerformance expects for control signals.
+
+template <class T>
+std::vector<T> CtrlNumerator(const std::vector<T>& num, const std::vector<T>& den, const std::vector<T>& plantDen)
+{
+    std::vector<T> u = PolyMul(num, plantDen);
+    auto n = den.size();
+    if (u.size() != n + 1)
+        ThrowError(__FILE__, __LINE__, "CtrlNumerator: num and den sizes do not match plant");
+    T q1 = u[n]/den[n-1];
+    std::vector<T> ctrlNum(n);
+    ctrlNum[0] = u[0];
+    for (unsigned i = 1; i < n; ++i)
+        ctrlNum[i] = u[i] - q1*den[i-1];
+    return ctrlNum;
+}
+
+template std::vector<double> CtrlNumerator(const std::vector<double>& num, const std::vector<double>& den,
+                                           const std::vector<double>& plantDen);
+template std::vector<Jet> CtrlNumerator(const std::vector<Jet>& num, const std::vector<Jet>& den,
+                                        const std::vector<Jet>& plantDen);
+
+template <class T>
+T EvalFitness(const T& J, const EvalParam& p)
+{
+    double optJ = sqrt(p.gamma);
+    T Jdev = (J/optJ) - 1.0;
+    return exp(-(Jdev*Jdev)/(2*p.fitVar));
+}
+
+template double EvalFitness(const double& J, const EvalParam& p);
+template Jet EvalFitness(const Jet& J, const EvalParam& p);
+
+// Variables of the Jets are the loci; EvalParam aSD and stochasticity are ignored, so the plant is nominal and phenotype is genotype. Same construction as EvalJ for orders other than 2, 2, which reduces to the original forms.
+
+bool EvalJet(const Allele *genotype, const EvalParam& p, Jet& J, Jet& fitness)
+{
+    double tmax = 20.0;
+    int loci = EvalLoci(p.loop, p.ctrlOrder);
+    if (loci > maxJetVars || EvalStateDim(p) < 2 || EvalStateDim(p) > maxNativeDim) return false;
+    Jet::setVars(loci);
+    std::vector<Jet> x(static_cast<size_t>(loci));
+    for (int i = 0; i < loci; ++i) x[static_cast<size_t>(i)] = Jet::variable(genotype[i], i);
+    std::vector<Jet> plantDen;
+    for (double c : PlantDen(sqrt(1+p.gamma), p.plantOrder)) plantDen.push_back(c);
+    std::vector<Jet> num, den, ctrlNum;
+    TransferPolys(x, p, plantDen, num, den);
+    unsigned long outTerms = (p.ctrlOrder != 2 || p.plantOrder != 2) ? num.size() : 3;
+    if (p.ctrlWt != 0.0) ctrlNum = CtrlNumerator(num, den, plantDen);
+    if (!performanceJet(num, ctrlNum, den, p.gamma, tmax,
+                        (p.loop == Loop::open) ? signalType::controlOpen : signalType::controlClosed, p.ctrlWt,
+                        outTerms, J))
+        return false;
+    fitness = EvalFitness(J, p);
+    return true;
+}
+
+// splitmix64 finalizer of seed and row, so nearby seeds and rows give unrelated streams
+
+unsigned long RowSeed(unsigned long seed, size_t row)
+{
+    uint64_t z = seed + (static_cast<uint64_t>(row) + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<unsigned long>(z ^ (z >> 31));
+}
+
+void EvalBatch(const Allele *genotypes, const Allele *stochasts, int loci, size_t rows,
+               const EvalParam& p, unsigned long seed, size_t firstRow, double *J, double *fitness)
+{
+    if (loci < EvalLoci(p.loop, p.ctrlOrder))
+        ThrowError(__FILE__, __LINE__, fmt::format("EvalBatch: loci = {} less than {} needed for loop type",
+                                                   loci, EvalLoci(p.loop, p.ctrlOrder)));
+    if (EvalStateDim(p) > maxStepDim)
+        ThrowError(__FILE__, __LINE__, fmt::format("EvalBatch: state dimension {} greater than {}",
+                                                   EvalStateDim(p), maxStepDim));
+    if (p.stoch && stochasts == nullptr)
+        ThrowError(__FILE__, __LINE__, "EvalBatch: stoch set but no stochast alleles");
+    if (getStepMethod() == stepMethod::parity)
+        ThrowError(__FILE__, __LINE__, "EvalBatch: parity step method is not thread safe");
+    bool random = p.stoch || std::abs(p.aSD) > 1e-6;
+    SAFrand_pcg<pcgT> r;
+    auto width = static_cast<size_t>(loci);
+    for (size_t i = 0; i < rows; ++i){
+        if (random) r.setRandSeed(static_cast<rndType>(RowSeed(seed, firstRow + i)));
+        J[i] = EvalJ(genotypes + i*width, (p.stoch) ? stochasts + i*width : nullptr, p, r);
+        fitness[i] = EvalFitness(J[i], p);
+    }
+}
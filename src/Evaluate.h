@@ -0,0 +1,54 @@
+#ifndef _Evaluate_h
+#define _Evaluate_h 1
+
+#include <cstddef>
+#include <vector>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Jet.h"
+
+// Evaluation of performance J and fitness for a genotype without Individual or Population. All state is explicit: parameters in EvalParam, random numbers from caller's generator, so calls are thread safe when each thread has its own generator. Individual::calcJExact calls EvalJ with its static parameters and the perturb stream of rndStreams, so the simulation and the batch code share one definition of J.
+
+// performance() is thread safe for stepMethod native or gsl with debugPerformance off; parity mode updates shared statistics, so EvalBatch rejects it.
+
+// Batch layout: row i of genotypes holds loci alleles, row major; if p.stoch, stochasts has the same layout, else may be nullptr. Row i of the whole batch draws its random numbers from a generator seeded with RowSeed(seed, i), so results do not depend on the number of threads, on how rows are split among calls, or on the order of evaluation. Rows without aSD or stochasticity use no random numbers.
+
+struct EvalParam {
+    Loop    loop;
+    double  gamma;
+    double  aSD;
+    double  stochWt;
+    bool    stoch;
+    double  fitVar;
+    double  ctrlWt;     // > 0 => add ctrlWt * squared error of control signal to J
+    int     ctrlOrder = 2;  // degree of controller numerator, see EvalTransferOrder
+    int     plantOrder = 2; // degree of plant denominator, see PlantDen
+};
+
+int             EvalLoci(Loop loop, int ctrlOrder = 2);     // number of alleles read by EvalJ
+int             EvalStateDim(const EvalParam& p);           // degree of den, state dimension of step response
+EvalParam       EvalNominal(const EvalParam& p);            // p without aSD and stochWt noise, for analyses of the final population
+bool            EvalStoch(double stochWt);                  // stochast alleles in use, for EvalParam stoch; one threshold for simulation and batch
+// num and den of system from genotype, coefficients from low to high order; returns plant parameter a
+double          EvalTransfer(const Allele *genotype, const Allele *stochast, const EvalParam& p, SAFrand_pcg<pcgT>& r,
+                             std::vector<double>& num, std::vector<double>& den);
+// orders other than 2, 2, called by EvalTransfer after drawing a
+void            EvalTransferOrder(const Allele *genotype, const Allele *stochast, const EvalParam& p,
+                                  SAFrand_pcg<pcgT>& r, double a, std::vector<double>& num, std::vector<double>& den);
+std::vector<double> PlantDen(double a, int order);
+// polynomials with coefficients from low to high order; templates over double and Jet
+template <class T> std::vector<T> PolyMul(const std::vector<T>& x, const std::vector<T>& y);
+template <class T> std::vector<T> PolyAdd(const std::vector<T>& x, const std::vector<T>& y);
+double          EvalJ(const Allele *genotype, const Allele *stochast, const EvalParam& p, SAFrand_pcg<pcgT>& r);
+template <class T> T EvalFitness(const T& J, const EvalParam& p);
+template <class T> std::vector<T> CtrlNumerator(const std::vector<T>& num, const std::vector<T>& den,
+                                                const std::vector<T>& plantDen);
+// J and fitness with gradient and Hessian with respect to the loci alleles of genotype, from one evaluation over Jets, for nominal plant without aSD or stochWt noise. False if loci > maxJetVars or state dimension outside native integration, see performanceJet.
+bool            EvalJet(const Allele *genotype, const EvalParam& p, Jet& J, Jet& fitness);
+unsigned long   RowSeed(unsigned long seed, size_t row);
+// rows of arrays are rows firstRow, firstRow+1, ... of the whole batch, which sets their seeds
+void            EvalBatch(const Allele *genotypes, const Allele *stochasts, int loci, size_t rows,
+                          const EvalParam& p, unsigned long seed, size_t firstRow, double *J, double *fitness);
+
+#endif
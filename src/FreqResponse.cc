@@ -0,0 +1,179 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "FreqResponse.h"
+#include "Robustness.h"
+#include "Evaluate.h"
+#include "Performance.h"
+
+const double wMin = 1e-2;
+const double wMax = 1e2;
+const int perDecade = 100;          // grid points per decade for margins
+const int printEvery = 10;          // grid points per printed line
+
+// Horner at s = iw for polynomials of all individuals, c[k*n + i] is coefficient of s^k of individual i
+
+void HornerIw(const std::vector<double>& c, size_t n, double w, std::vector<double>& re, std::vector<double>& im)
+{
+    size_t K = c.size()/n;
+    for (size_t i = 0; i < n; ++i){
+        re[i] = c[(K-1)*n + i];
+        im[i] = 0.0;
+    }
+    for (size_t k = K-1; k-- > 0;){
+        const double *ck = &c[k*n];
+        for (size_t i = 0; i < n; ++i){
+            double r = ck[i] - im[i]*w;
+            im[i] = re[i]*w;
+            re[i] = r;
+        }
+    }
+}
+
+// angle in (-pi, pi]
+
+double WrapAngle(double x)
+{
+    while (x > M_PI) x -= 2.0*M_PI;
+    while (x <= -M_PI) x += 2.0*M_PI;
+    return x;
+}
+
+std::string FreqResponse(Population& pop, Param& param)
+{
+    EvalParam det = EvalNominal(Individual::getEvalParam());
+    bool feedback = (det.loop != Loop::open);
+    auto total = static_cast<size_t>(std::min(param.freqResp, pop.getPopSize()));
+
+    // coefficients of stable individuals, by coefficient then individual
+    SAFrand_pcg<pcgT> r;        // no noise, so no draws
+    std::vector<double> num, den, num0, den0;
+    std::vector<Allele> g0(static_cast<size_t>(param.loci));
+    std::vector<std::vector<double>> cNum, cDen, cD0;
+    int unstable = 0;
+    for (size_t k = 0; k < total; ++k){
+        auto& ind = pop.sampleInd(k, total);
+        const Allele *g = ind.getGenotype().get();
+        EvalTransfer(g, nullptr, det, r, num, den);
+        if (MaxRootRealPart(den) > -1e-6){
+            ++unstable;
+            continue;
+        }
+        // controller numerator alleles zero, see EvalTransferOrder
+        std::copy_n(g, g0.size(), g0.begin());
+        std::fill_n(&g0[static_cast<size_t>(det.ctrlOrder)], det.ctrlOrder + 1, 0.0f);
+        EvalTransfer(g0.data(), nullptr, det, r, num0, den0);
+        if (cNum.empty()){
+            cNum.resize(num.size());
+            cDen.resize(den.size());
+            cD0.resize(den0.size());
+        }
+        for (size_t j = 0; j < num.size(); ++j) cNum[j].push_back(num[j]);
+        for (size_t j = 0; j < den.size(); ++j) cDen[j].push_back(den[j]);
+        for (size_t j = 0; j < den0.size(); ++j) cD0[j].push_back(den0[j]);
+    }
+    std::string out = fmt::format("Frequency response, {} individuals, {} unstable left out, w = {:.0e} .. {:.0e}\n\n",
+                                  total, unstable, wMin, wMax);
+    if (cNum.empty()) return out + "No stable individuals\n\n\n";
+    size_t n = cNum[0].size();
+    auto flatten = [](const std::vector<std::vector<double>>& v){
+        std::vector<double> c;
+        for (auto& x : v) c.insert(c.end(), x.begin(), x.end());
+        return c;
+    };
+    auto fNum = flatten(cNum), fDen = flatten(cDen), fD0 = flatten(cD0);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::nan("");
+    std::vector<double> nr(n), ni(n), dr(n), di(n), er(n), ei(n), magG(n), magS(n);
+    std::vector<double> Lr(n), Li(n), Lm(n), prevLr(n), prevLi(n), prevLm(n);
+    std::vector<double> gm(n, inf), pm(n, inf), wgc(n, nan), ms(n, 0.0);
+    std::vector<double> sorted(n);
+
+    out += fmt::format("{:>10}", "w");
+    for (auto s : {"|G| 5%", "25%", "50%", "75%", "95%"}) out += fmt::format("{:>11}", s);
+    if (feedback) for (auto s : {"|S| 50%", "95%"}) out += fmt::format("{:>11}", s);
+    out += "\n";
+    int steps = static_cast<int>(std::lround(log10(wMax/wMin)*perDecade));
+    double dlw = log(wMax/wMin)/steps;
+    for (int f = 0; f <= steps; ++f){
+        double lw = log(wMin) + f*dlw;
+        double w = exp(lw);
+        HornerIw(fNum, n, w, nr, ni);
+        HornerIw(fDen, n, w, dr, di);
+        for (size_t i = 0; i < n; ++i)
+            magG[i] = sqrt((nr[i]*nr[i] + ni[i]*ni[i])/(dr[i]*dr[i] + di[i]*di[i]));
+        if (feedback){
+            HornerIw(fD0, n, w, er, ei);
+            // S = d0/den, L = den/d0 - 1
+            for (size_t i = 0; i < n; ++i){
+                double dd = dr[i]*dr[i] + di[i]*di[i];
+                double ee = er[i]*er[i] + ei[i]*ei[i];
+                magS[i] = sqrt(ee/dd);
+                Lr[i] = (dr[i]*er[i] + di[i]*ei[i])/ee - 1.0;
+                Li[i] = (di[i]*er[i] - dr[i]*ei[i])/ee;
+                Lm[i] = 0.5*log(Lr[i]*Lr[i] + Li[i]*Li[i]);
+                ms[i] = std::max(ms[i], magS[i]);
+            }
+            // crossings between previous and current grid point, interpolated in log w
+            for (size_t i = 0; i < n && f > 0; ++i){
+                if ((prevLm[i] < 0.0) != (Lm[i] < 0.0)){
+                    double t = prevLm[i]/(prevLm[i] - Lm[i]);
+                    double a0 = atan2(prevLi[i], prevLr[i]);
+                    double a = WrapAngle(a0 + t*WrapAngle(atan2(Li[i], Lr[i]) - a0));
+                    double margin = 180.0 + a*180.0/M_PI;
+                    if (margin > 180.0) margin -= 360.0;
+                    if (margin < pm[i]){
+                        pm[i] = margin;
+                        wgc[i] = exp(lw - (1.0 - t)*dlw);
+                    }
+                }
+                if ((prevLi[i] < 0.0) != (Li[i] < 0.0)){
+                    double t = prevLi[i]/(prevLi[i] - Li[i]);
+                    double re = prevLr[i] + t*(Lr[i] - prevLr[i]);
+                    if (re < 0.0) gm[i] = std::min(gm[i], -20.0*log10(-re));
+                }
+            }
+            std::swap(prevLr, Lr);
+            std::swap(prevLi, Li);
+            std::swap(prevLm, Lm);
+        }
+        if (f % printEvery != 0) continue;
+        out += fmt::format("{:10.3e}", w);
+        sorted = magG;
+        std::sort(sorted.begin(), sorted.end());
+        for (double q : {0.05, 0.25, 0.5, 0.75, 0.95}) out += fmt::format("{:11.3e}", SortedPercentile(sorted, q));
+        if (feedback){
+            sorted = magS;
+            std::sort(sorted.begin(), sorted.end());
+            for (double q : {0.5, 0.95}) out += fmt::format("{:11.3e}", SortedPercentile(sorted, q));
+        }
+        out += "\n";
+    }
+    if (!feedback) return out + "\n\n";
+
+    // no crossing within grid is left out of margin rows and counted
+    int noGain = 0, noPhase = 0;
+    for (size_t i = 0; i < n; ++i){
+        if (std::isinf(pm[i])){
+            pm[i] = nan;
+            ++noGain;
+        }
+        if (std::isinf(gm[i])){
+            gm[i] = nan;
+            ++noPhase;
+        }
+    }
+    out += fmt::format("\nMargins of loop gain L = den/d0 - 1; no gain crossover = {}, no phase crossover = {}\n\n",
+                       noGain, noPhase);
+    out += fmt::format("{:>5}", "");
+    for (auto s : {"Mean", "SD", "5%", "25%", "50%", "75%", "95%"}) out += fmt::format("{:>11}", s);
+    out += "\n";
+    out += RobustnessRow("GMdB", gm);
+    out += RobustnessRow("PM", pm);
+    out += RobustnessRow("wgc", wgc);
+    out += RobustnessRow("Ms", ms);
+    return out + "\n\n";
+}
@@ -0,0 +1,18 @@
+#ifndef _FreqResponse_h
+#define _FreqResponse_h 1
+
+#include <string>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Population.h"
+
+// Frequency response of final population, param freqResp > 0 individuals, evenly spaced in population order as for RobustnessScan. Transfer functions from EvalTransfer without aSD or stochWt noise, so response of genotype with nominal plant.
+
+// System G = num/den, whose step response sets J. For close and dclose, den = d0 + feedback terms, in which d0 is den with controller numerator alleles set to zero, q0, q1, q2 for orders 2, 2, product of controller denominator and plant denominator, times s for dclose. Breaking loop at d0 gives return difference 1 + L = den/d0, so sensitivity S = d0/den and loop gain L = den/d0 - 1; for close, L = C P as usual. Open loop has no feedback, so no margins.
+
+// Evaluated on log spaced grid of w, s = iw, by Horner over coefficient arrays laid out by individual, one frequency at a time, so inner loops run over individuals with unit stride and memory is O(individuals). Output: percentiles of |G| and |S| at every printEvery grid point; per individual gain margin at phase crossover, Im L = 0 with Re L < 0, phase margin and frequency at gain crossover, |L| = 1, both interpolated in log w and min over crossings, and peak of |S|. Individuals with unstable den, as in performance(), are left out and counted.
+
+std::string FreqResponse(Population& pop, Param& param);
+
+#endif
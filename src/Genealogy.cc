@@ -0,0 +1,207 @@
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+
+#include "Genealogy.h"
+
+void Genealogy::initialize(int l, int simplifyInterval)
+{
+    loci = l;
+    interval = simplifyInterval;
+    time = 0;
+    nodes.clear();
+    edges.clear();
+    mutations.clear();
+    sampleIds.clear();
+}
+
+int Genealogy::addNode()
+{
+    nodes.push_back({time});
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+// Runs of set bits in mask come from parent1, runs of unset bits from parent2
+
+void Genealogy::addEdges(int parent1, int parent2, const std::vector<uint64_t>& mask, int child)
+{
+    auto bit = [&](int i){return (mask[i >> 6] >> (i & 63)) & 1;};
+    int left = 0;
+    for (int i = 1; i <= loci; ++i){
+        if (i == loci || bit(i) != bit(left)){
+            edges.push_back({left, i, (bit(left)) ? parent1 : parent2, child});
+            left = i;
+        }
+    }
+}
+
+// A[n] holds segments [left,right) on which the lineage through node n leads to output node. Process parents from youngest to oldest; for each parent, intersect segments of its children with the edges to those children. Where two or more segments overlap, the parent is a coalescence, becomes an output node and gets output edges; where only one segment, the lineage passes through parent unchanged.
+
+std::vector<int> Genealogy::simplify(const std::vector<int>& samples)
+{
+    std::vector<std::vector<Seg>> A(nodes.size());
+    std::vector<Node> outNodes;
+    std::vector<Edge> outEdges;
+    std::vector<int> newSample(samples.size());
+    auto pushSeg = [](std::vector<Seg>& a, Seg s){
+        if (!a.empty() && a.back().right == s.left && a.back().node == s.node)
+            a.back().right = s.right;
+        else
+            a.push_back(s);
+    };
+    for (unsigned i = 0; i < samples.size(); ++i){
+        newSample[i] = static_cast<int>(outNodes.size());
+        outNodes.push_back(nodes[samples[i]]);
+        A[samples[i]].push_back({0, loci, newSample[i]});
+    }
+
+    std::vector<unsigned> order(edges.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](unsigned a, unsigned b){return edges[a].parent > edges[b].parent;});
+    std::vector<Seg> X;
+    std::vector<int> bounds;
+    unsigned k = 0;
+    while (k < order.size()){
+        int p = edges[order[k]].parent;
+        X.clear();
+        for (; k < order.size() && edges[order[k]].parent == p; ++k){
+            auto& e = edges[order[k]];
+            for (auto& s : A[e.child]){
+                int l = std::max(s.left, e.left);
+                int r = std::min(s.right, e.right);
+                if (l < r) X.push_back({l, r, s.node});
+            }
+        }
+        if (X.empty()) continue;
+        bounds.clear();
+        for (auto& s : X){
+            bounds.push_back(s.left);
+            bounds.push_back(s.right);
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        int v = -1;
+        for (unsigned b = 0; b + 1 < bounds.size(); ++b){
+            int l = bounds[b];
+            int r = bounds[b+1];
+            int count = 0;
+            int u = -1;
+            for (auto& s : X){
+                if (s.left <= l && s.right >= r){
+                    ++count;
+                    u = s.node;
+                }
+            }
+            if (count == 1)
+                pushSeg(A[p], {l, r, u});
+            else if (count > 1){
+                if (v < 0){
+                    v = static_cast<int>(outNodes.size());
+                    outNodes.push_back(nodes[p]);
+                }
+                for (auto& s : X)
+                    if (s.left <= l && s.right >= r)
+                        outEdges.push_back({l, r, v, s.node});
+                pushSeg(A[p], {l, r, v});
+            }
+        }
+    }
+
+    std::vector<Mutation> outMut;
+    for (auto& m : mutations){
+        for (auto& s : A[m.node]){
+            if (s.left <= m.locus && m.locus < s.right){
+                outMut.push_back({s.node, m.locus, m.time, m.stoch, m.value});
+                break;
+            }
+        }
+    }
+
+    // renumber output nodes by time, so parents have smaller ids than children
+    std::vector<int> byTime(outNodes.size());
+    std::iota(byTime.begin(), byTime.end(), 0);
+    std::stable_sort(byTime.begin(), byTime.end(),
+                     [&](int a, int b){return outNodes[a].time < outNodes[b].time;});
+    std::vector<int> newId(outNodes.size());
+    nodes.resize(outNodes.size());
+    for (unsigned i = 0; i < byTime.size(); ++i){
+        newId[byTime[i]] = static_cast<int>(i);
+        nodes[i] = outNodes[byTime[i]];
+    }
+    for (auto& e : outEdges){
+        e.parent = newId[e.parent];
+        e.child = newId[e.child];
+    }
+    for (auto& m : outMut) m.node = newId[m.node];
+    for (auto& s : newSample) s = newId[s];
+
+    // squash adjacent edges with same parent and child
+    std::sort(outEdges.begin(), outEdges.end(), [](const Edge& a, const Edge& b){
+        return (a.child != b.child) ? a.child < b.child :
+               (a.parent != b.parent) ? a.parent < b.parent : a.left < b.left;});
+    edges.clear();
+    for (auto& e : outEdges){
+        if (!edges.empty() && edges.back().child == e.child && edges.back().parent == e.parent
+            && edges.back().right == e.left)
+            edges.back().right = e.right;
+        else
+            edges.push_back(e);
+    }
+    mutations = std::move(outMut);
+    sampleIds = newSample;
+    return newSample;
+}
+
+// Call after simplify. At each locus, roots are sample or parent nodes that are not children at that locus; one root means all sample lineages have coalesced.
+
+std::vector<int> Genealogy::tmrca()
+{
+    std::vector<int> result(loci);
+    std::vector<char> isChild(nodes.size());
+    std::vector<char> inTree(nodes.size());
+    for (int x = 0; x < loci; ++x){
+        std::fill(isChild.begin(), isChild.end(), 0);
+        std::fill(inTree.begin(), inTree.end(), 0);
+        for (auto s : sampleIds) inTree[s] = 1;
+        for (auto& e : edges){
+            if (e.left <= x && x < e.right){
+                isChild[e.child] = 1;
+                inTree[e.parent] = 1;
+            }
+        }
+        int roots = 0;
+        int root = -1;
+        for (unsigned i = 0; i < nodes.size(); ++i){
+            if (inTree[i] && !isChild[i]){
+                ++roots;
+                root = static_cast<int>(i);
+            }
+        }
+        result[x] = (roots == 1) ? time - nodes[root].time : -1;
+    }
+    return result;
+}
+
+void Genealogy::write(const std::string& filename)
+{
+    std::ofstream out(filename);
+    if (!out)
+        ThrowError(__FILE__, __LINE__, "Could not open " + filename);
+    out << fmt::format("# genealogy, time is generation of birth, current generation = {}\n", time);
+    out << "# tmrca by locus, -1 => not coalesced\n";
+    for (auto t : tmrca()) out << t << " ";
+    out << "\n# nodes: id time sample\n";
+    std::vector<char> isSample(nodes.size());
+    for (auto s : sampleIds) isSample[s] = 1;
+    for (unsigned i = 0; i < nodes.size(); ++i)
+        out << fmt::format("{} {} {}\n", i, nodes[i].time, static_cast<int>(isSample[i]));
+    out << "# edges: left right parent child\n";
+    for (auto& e : edges)
+        out << fmt::format("{} {} {} {}\n", e.left, e.right, e.parent, e.child);
+    out << "# mutations: node locus time stoch value\n";
+    for (auto& m : mutations)
+        out << fmt::format("{} {} {} {} {}\n", m.node, m.locus, m.time, static_cast<int>(m.stoch), m.value);
+    if (!out)
+        ThrowError(__FILE__, __LINE__, "Error writing " + filename);
+}
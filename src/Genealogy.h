@@ -0,0 +1,48 @@
+#ifndef _Genealogy_h
+#define _Genealogy_h 1
+
+#include <vector>
+#include <string>
+
+#include APPL_H
+#include "typedefs.h"
+
+// Genealogy of population stored as tables in the style of tree sequences. Each individual born is a node with the generation of its birth. Each offspring gets edges [left,right) over loci to the parent from which it copied those loci, as given by the crossover mask of SetBabyGenotype*. Mutations record node, locus and new allelic value; stochast mutations flagged, because stochast alleles are linked to genotype alleles, they share the edges.
+
+// Tables only grow by appending. Every simplifyInterval generations, simplify to the ancestry of the current population: keep samples and nodes at which two or more sample lineages coalesce at some locus, pass edges through all other nodes, and move mutations to the nearest retained descendant. Memory then scales with retained lineages rather than popsize * generations.
+
+// Node ids are ordered by time, parents always have smaller ids than children.
+
+class Genealogy
+{
+public:
+    struct Node {int time;};
+    struct Edge {int left; int right; int parent; int child;};
+    struct Mutation {int node; int locus; int time; bool stoch; Allele value;};
+    void    initialize(int loci, int interval);
+    int     addNode();                      // born in current generation
+    void    addEdges(int parent1, int parent2, const std::vector<uint64_t>& mask, int child);
+    void    addEdge(int parent, int child){edges.push_back({0, loci, parent, child});}
+    void    addMutation(int node, int locus, bool stoch, Allele value)
+                {mutations.push_back({node, locus, time, stoch, value});}
+    void    setTime(int t){time = t;}
+    int     getTime(){return time;}
+    bool    simplifyDue(){return interval > 0 && time > 0 && time % interval == 0;}
+    std::vector<int> simplify(const std::vector<int>& samples);    // returns new ids of samples
+    std::vector<int> tmrca();               // per locus, -1 if sample lineages not coalesced
+    void    write(const std::string& filename);
+    auto    getNodes(){return nodes.size();}
+    auto    getEdges(){return edges.size();}
+    auto    getMutations(){return mutations.size();}
+private:
+    struct Seg {int left; int right; int node;};
+    int     loci;
+    int     interval;
+    int     time;                           // current generation
+    std::vector<Node>       nodes;
+    std::vector<Edge>       edges;
+    std::vector<Mutation>   mutations;
+    std::vector<int>        sampleIds;      // after last simplify
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Gradient.h"
+#include "Evaluate.h"
+#include "Jet.h"
+
+std::string SelectionGradient(Population& pop, Param& param)
+{
+    EvalParam det = EvalNominal(Individual::getEvalParam());
+    auto total = static_cast<size_t>(std::min(param.selGrad, pop.getPopSize()));
+    auto L = static_cast<size_t>(param.loci);
+    std::string skip = fmt::format("Selection gradients, {} individuals\n\n", total);
+    if (param.loci > maxJetVars)
+        return skip + fmt::format("Skipped, {} loci more than {} of Jet\n\n\n", param.loci, maxJetVars);
+
+    std::vector<double> dw(L, 0.0), dJ(L, 0.0), d2w(L*L, 0.0);
+    double wSum = 0.0;
+    int unstable = 0;
+    for (size_t k = 0; k < total; ++k){
+        auto& ind = pop.sampleInd(k, total);
+        Jet J, w;
+        if (!EvalJet(ind.getGenotype().get(), det, J, w))
+            return skip + "Skipped, state dimension outside native integration\n\n\n";
+        if (J.v >= 1e20) ++unstable;
+        wSum += w.v;
+        for (size_t i = 0, h = 0; i < L; ++i){
+            dw[i] += w.g[i];
+            dJ[i] += J.g[i];
+            for (size_t j = i; j < L; ++j, ++h) d2w[i*L + j] += w.h[h];
+        }
+    }
+    double n = static_cast<double>(total);
+    double wBar = wSum/n;
+    std::string out = fmt::format("Selection gradients, {} individuals, {} unstable, mean fitness {:.3e}\n\n", total, unstable, wBar);
+    if (!(wBar > 0.0)) return out + "No fitness to scale gradients\n\n\n";
+
+    out += "      ";
+    for (size_t i = 0; i < L; ++i) out += fmt::format((i < 10) ? "{:>9}{:1}" : "{:>8}{:2}", "g", i);
+    out += "\n  beta";
+    for (size_t i = 0; i < L; ++i) out += fmt::format("{:10.2e}", dw[i]/n/wBar);
+    out += "\n dJ/dg";
+    for (size_t i = 0; i < L; ++i) out += fmt::format("{:10.2e}", dJ[i]/n);
+    out += "\n\ngamma ";
+    for (size_t i = 0; i < L; ++i) out += fmt::format((i < 10) ? "{:>9}{:1}" : "{:>8}{:2}", "g", i);
+    out += "\n";
+    for (size_t i = 0; i < L; ++i){
+        out += fmt::format((i < 10) ? "{:>5}{:1}" : "{:>4}{:2}", "g", i);
+        for (size_t j = 0; j < L; ++j)
+            out += fmt::format("{:10.2e}", d2w[std::min(i, j)*L + std::max(i, j)]/n/wBar);
+        out += "\n";
+    }
+    return out + "\n\n";
+}
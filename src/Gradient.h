@@ -0,0 +1,16 @@
+#ifndef _Gradient_h
+#define _Gradient_h 1
+
+#include <string>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Population.h"
+
+// Selection gradients of final population, param selGrad > 0 individuals, evenly spaced in population order as for RobustnessScan. Each individual gets J and fitness w with their gradients and Hessians with respect to all loci from one evaluation over Jets, see EvalJet, instead of 2 loci or more evaluations of finite differences; nominal plant without aSD or stochWt noise, so the local shape of the deterministic fitness surface.
+
+// Averages over individuals, with w bar the mean fitness: beta = mean grad w / w bar and gamma = mean Hessian of w / w bar, which for normally distributed genotypes equal the linear and quadratic selection gradients of Lande and Arnold; and mean grad J. Unstable individuals count with w = 0 and zero derivatives, as their fitness is. Needs loci <= maxJetVars and state dimension of native integration, else reports that it is skipped.
+
+std::string SelectionGradient(Population& pop, Param& param);
+
+#endif
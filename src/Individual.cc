@@ -1,12 +1,17 @@
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "Individual.h"
 #include "Performance.h"
+#include "Evaluate.h"
 
 // declare static private member variables
 
 double Individual::mut;
 double Individual::rec;
 int Individual::totalLoci;
+int Individual::traits;
+int Individual::polyLoci;
 Allele Individual::mutStep;
 double Individual::aSD;
 double Individual::fitVar;
@@ -16,6 +21,16 @@ int Individual::mutLocus;
 double Individual::stochWt;
 bool Individual::stoch;
 ulong Individual::negLog2Rec;
+bool Individual::recSkip;
+uint32_t Individual::recThreshold;
+double Individual::invLogNoRec;
+std::vector<uint64_t> Individual::crossMask;
+bool Individual::logMut = false;
+std::vector<Individual::MutLog> Individual::mutLog;
+uint64_t Individual::exactEvals = 0;
+JTable Individual::jTable;
+Surrogate Individual::surrogate;
+EvalParam Individual::evalParam;
 
 // Algorithm for fast Poisson for lambda < 30
 // from https://www.johndcook.com/blog/2010/06/14/generating-poisson-random-values/
@@ -26,9 +41,10 @@ int MyRandomPoisson(double mean)
     int k = 0;
     double p = 1.0;
     double L = exp(-mean);
+    auto& r = *rndStreams.vary;
     while (p > L){
         k++;
-        p *= rnd.rU01();
+        p *= r.rU01();
     }
     return k-1;
 }
@@ -36,33 +52,98 @@ int MyRandomPoisson(double mean)
 // copy constructor
 Individual::Individual(const Individual& other)
 {
-    genotype = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
-    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
-    for (int i = 0; i < totalLoci; ++i){
+    genotype = std::unique_ptr<Allele[]> {new Allele[traits]};
+    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[traits]};
+    for (int i = 0; i < traits; ++i){
         genotype[i] = other.genotype[i];
         if (stoch) stochast[i] = other.stochast[i];
     }
+    if (polyLoci > 1){
+        alleles = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
+        std::memcpy(alleles.get(), other.alleles.get(), static_cast<size_t>(totalLoci)*sizeof(Allele));
+        traitSum = std::unique_ptr<double[]> {new double[traits]};
+        std::memcpy(traitSum.get(), other.traitSum.get(), static_cast<size_t>(traits)*sizeof(double));
+    }
     fitness = other.fitness;
+    node = other.node;
 }
 
 // assignment constructor
 Individual& Individual::operator=(const Individual& other)
 {
-    genotype = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
-    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
-    for (int i = 0; i < totalLoci; ++i){
+    genotype = std::unique_ptr<Allele[]> {new Allele[traits]};
+    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[traits]};
+    for (int i = 0; i < traits; ++i){
         genotype[i] = other.genotype[i];
         if (stoch) stochast[i] = other.stochast[i];
     }
+    if (polyLoci > 1){
+        alleles = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
+        std::memcpy(alleles.get(), other.alleles.get(), static_cast<size_t>(totalLoci)*sizeof(Allele));
+        traitSum = std::unique_ptr<double[]> {new double[traits]};
+        std::memcpy(traitSum.get(), other.traitSum.get(), static_cast<size_t>(traits)*sizeof(double));
+    }
     fitness = other.fitness;
+    node = other.node;
     return *this;
 }
 
 void Individual::initialize()
 {
-    genotype = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
+    setInitialGenotype();
+    if (polyLoci > 1){
+        // initial trait value split evenly among its loci, then each locus perturbed as a single locus is
+        for (int t = 0; t < traits; ++t){
+            double sum = 0.0;
+            for (int j = 0; j < polyLoci; ++j){
+                Allele& a = alleles[t*polyLoci + j];
+                a = genotype[t]/static_cast<Allele>(polyLoci);
+                if (mutLocus < 0 || mutLocus == t) a = mutateStep(a);
+                sum += a;
+            }
+            // traits other than mutLocus keep exact initial value, as JTable assumes
+            if (mutLocus < 0 || mutLocus == t) genotype[t] = static_cast<Allele>(sum);
+            traitSum[t] = (mutLocus < 0 || mutLocus == t) ? sum : genotype[t];
+        }
+    }
+    else if (mutLocus >= 0){
+        genotype[mutLocus] = mutateStep(genotype[mutLocus]);
+        if (stoch) stochast [mutLocus] = mutateStep(stochast[mutLocus]);
+    }
+    else{
+        for (int i = 0; i < totalLoci; ++i){
+            genotype[i] = mutateStep(genotype[i]);
+            if (stoch){
+                stochast[i] = mutateStep(stochast[i]);
+                if (stochast[i] < 0) stochast[i] = static_cast<Allele>(0);
+            }
+        }
+    }
+    fitness = calcFitness();
+}
+
+// Allele arrays without values, for individuals that are overwritten before use
+
+void Individual::allocate()
+{
+    genotype = std::unique_ptr<Allele[]> {new Allele[traits]};
     // init to zero with {} initializer
-    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[totalLoci]{}};
+    if (stoch) stochast = std::unique_ptr<Allele[]> {new Allele[traits]{}};
+    if (polyLoci > 1){
+        alleles = std::unique_ptr<Allele[]> {new Allele[totalLoci]};
+        traitSum = std::unique_ptr<double[]> {new double[traits]};
+    }
+}
+
+// Deterministic starting values before mutational perturbation, no random numbers used
+
+void Individual::setInitialGenotype()
+{
+    allocate();
+    if (evalParam.ctrlOrder != 2 || evalParam.plantOrder != 2){
+        setInitialGenotypeOrder();
+        return;
+    }
     float p = static_cast<float>(1.0/sqrt(gamma));
     // p0 = 0 by assumption
     genotype[2] = p;                // q0
@@ -86,21 +167,50 @@ void Individual::initialize()
             genotype[6] = k;        // k
             break;
     }
+}
 
-    if (mutLocus >= 0){
-        genotype[mutLocus] = mutateStep(genotype[mutLocus]);
-        if (stoch) stochast [mutLocus] = mutateStep(stochast[mutLocus]);
+// Generic orders m, n, see EvalTransferOrder: with lag F = 1 + s/10, q = p Pd F^(m-n) and pt = c F^(m-2), c as for orders 2, 2: s + p open, s close, k s + 1 - p dclose, p = 1/sqrt(gamma). Reduces to the values above for m = n = 2. Open loop start is always stable. For close, loop gain is p/(s F^(n-2)), so stable for n <= 3 and for n >= 4 only if p is below the critical gain w (1 + w^2/100)^((n-2)/2), w = 10 tan(pi/(2(n-2))), eg gamma > 0.0025 for n = 4, gamma > 0.092 for n = 8. dclose start needs larger gamma for n >= 3, and is unstable for all gamma <= 1 when n >= 5. GetParam rejects unstable starts with initialOrderStable. Needs m >= n >= 2, checked in GetParam.
+
+std::vector<Allele> Individual::initialGenotypeOrder(const EvalParam& ep)
+{
+    int m = ep.ctrlOrder, n = ep.plantOrder;
+    double p = 1.0/sqrt(ep.gamma);
+    double r = 10.0, k = 1/r;           // dclose, as above
+    std::vector<double> lag = {1.0, 0.1}, fm = {1.0}, fc = {1.0};
+    for (int i = n; i < m; ++i) fm = PolyMul(fm, lag);
+    for (int i = 2; i < m; ++i) fc = PolyMul(fc, lag);
+    std::vector<double> q = PolyMul(PolyMul({p}, PlantDen(sqrt(1+ep.gamma), n)), fm);
+    std::vector<double> c;
+    switch (ep.loop){
+        case Loop::open:    c = {p, 1.0}; break;
+        case Loop::close:   c = {0.0, 1.0}; break;
+        case Loop::dclose:  c = {1.0 - p, k}; break;
     }
-    else{
-        for (int i = 0; i < totalLoci; ++i){
-            genotype[i] = mutateStep(genotype[i]);
-            if (stoch){
-                stochast[i] = mutateStep(stochast[i]);
-                if (stochast[i] < 0) stochast[i] = static_cast<Allele>(0);
-            }
-        }
+    std::vector<double> pt = PolyMul(c, fc);
+    std::vector<Allele> g(static_cast<size_t>(EvalLoci(ep.loop, m)));
+    for (int j = 0; j < m; ++j) g[static_cast<size_t>(m - 1 - j)] = static_cast<Allele>(pt[static_cast<size_t>(j)]);
+    for (int j = 0; j <= m; ++j) g[static_cast<size_t>(2*m - j)] = static_cast<Allele>(q[static_cast<size_t>(j)]);
+    if (ep.loop == Loop::dclose){
+        g[static_cast<size_t>(2*m + 1)] = static_cast<Allele>(r);
+        g[static_cast<size_t>(2*m + 2)] = static_cast<Allele>(k);
     }
-    fitness = calcFitness();
+    return g;
+}
+
+void Individual::setInitialGenotypeOrder()
+{
+    std::vector<Allele> g = initialGenotypeOrder(evalParam);
+    std::copy(g.begin(), g.end(), genotype.get());
+}
+
+// Closed loop of initial genotype has all roots in left half plane, see initialGenotypeOrder
+
+bool Individual::initialOrderStable(const EvalParam& ep, SAFrand_pcg<pcgT>& r)
+{
+    std::vector<Allele> g = initialGenotypeOrder(ep);
+    std::vector<double> num, den;
+    EvalTransfer(g.data(), nullptr, EvalNominal(ep), r, num, den);
+    return MaxRootRealPart(den) < 0.0;
 }
 
 // set static variables used by class
@@ -109,8 +219,10 @@ void Individual::setParam(Param& param)
 {
     mut = param.mutation;
     rec = param.recombination;
-    totalLoci = param.loci;
-    mutStep = param.mutStep;
+    traits = param.loci;
+    polyLoci = param.polyLoci;
+    totalLoci = traits*polyLoci;
+    mutStep = static_cast<Allele>(param.mutStep/sqrt(polyLoci));
     aSD = param.aSD;
     fitVar = param.fitVar;
     gamma = param.gamma;
@@ -119,13 +231,44 @@ void Individual::setParam(Param& param)
     stochWt = param.stochWt;
     stoch = param.stoch;
     negLog2Rec = 1;         // set elsewhere when needed, here is just default value
+    recSkip = (rec < 1.0/1024.0);
+    recThreshold = static_cast<uint32_t>(std::min(rec, 1.0) * 65536.0 + 0.5);
+    invLogNoRec = (recSkip && rec > 0.0) ? 1.0/log1p(-rec) : 0.0;
+    crossMask = std::vector<uint64_t>((totalLoci + 63)/64);
+    evalParam = {loop, gamma, aSD, stochWt, stoch, fitVar, param.ctrlWt, param.ctrlOrder, param.plantOrder};
+}
+
+// With mutLocus >= 0, all other loci keep their initial values, and with no aSD or stochastic fluctuations, J depends only on allele at mutLocus. Initial table covers +/- 8 mutational steps from initial value and extends as needed. Call after setParam.
+
+void Individual::setJTable(Param& param)
+{
+    if (param.tableErr <= 0 || mutLocus < 0 || stoch || std::abs(aSD) > 1e-6){
+        jTable.clear();
+        return;
+    }
+    Individual probe;
+    probe.setInitialGenotype();
+    Allele center = probe.genotype[mutLocus];
+    auto exactJ = [probe](Allele x) mutable {probe.genotype[mutLocus] = x; return probe.calcJExact();};
+    jTable.build(exactJ, center, 8*mutStep, param.tableErr);
+}
+
+// Multi-locus counterpart of setJTable, surrTol is max predicted error of J. Call after setParam.
+
+void Individual::setSurrogate(Param& param)
+{
+    if (param.surrTol <= 0 || mutLocus >= 0 || stoch || std::abs(aSD) > 1e-6){
+        surrogate.clear();
+        return;
+    }
+    surrogate.build(traits, param.surrTol);
 }
 
 // could use bit cache for random bits to speed up
 
 Allele Individual::mutateStep(Allele a)
 {
-    auto c = static_cast<Allele>(rnd.rUniform(-mutStep,mutStep));
+    auto c = static_cast<Allele>(rndStreams.vary->rUniform(-mutStep,mutStep));
     return a + c;
 }
 
@@ -133,75 +276,223 @@ Allele Individual::mutateStep(Allele a)
 
 void Individual::mutate()
 {
+    if (logMut) mutLog.clear();
+    if (polyLoci > 1){
+        mutatePoly();
+        return;
+    }
     mutateG(genotype, false);
     if (stoch) mutateG(stochast, true);
 }
 
+// Sparse polygenic mutation, see Individual.h: mut per locus over all loci, or over the loci of trait mutLocus. Poisson by inversion is O(mean), so large means use the generator's method.
+
+void Individual::mutatePoly()
+{
+    int first = (mutLocus >= 0) ? mutLocus*polyLoci : 0;
+    int n = (mutLocus >= 0) ? polyLoci : totalLoci;
+    double lambda = mut*n;
+    auto& r = *rndStreams.vary;
+    int hits = (lambda < 30.0) ? MyRandomPoisson(lambda) : r.poisson(lambda);
+    for (int i = 0; i < hits; ++i){
+        auto locus = first + static_cast<int>(r.rtop(n));
+        Allele old = alleles[locus];
+        alleles[locus] = mutateStep(old);
+        int t = locus/polyLoci;
+        traitSum[t] += static_cast<double>(alleles[locus]) - static_cast<double>(old);
+        genotype[t] = static_cast<Allele>(traitSum[t]);
+    }
+}
+
 // s == true => set negative values to zero, used for stochastic parameters which are standard deviations and so must be nonnegative
 void Individual::mutateG(std::unique_ptr<Allele []>& g, bool s)
 {
     if (mutLocus >= 0){
-        if (rnd.rU01() < mut)
+        if (rndStreams.vary->rU01() < mut){
             g[mutLocus] = mutateStep(g[mutLocus]);
+            if (logMut) mutLog.push_back({mutLocus, s, g[mutLocus]});
+        }
     }
     else{
         int hits = MyRandomPoisson(mut*totalLoci);  // about twice as fast as rnd.poisson()
         for (int i = 0; i < hits; ++i){
-            ulong locus = rnd.rtop(totalLoci);
+            ulong locus = rndStreams.vary->rtop(totalLoci);
             g[locus] = mutateStep(g[locus]);
             if (s && (g[locus] < 0)) g[locus] = static_cast<Allele>(0);
+            if (logMut) mutLog.push_back({static_cast<int>(locus), s, g[locus]});
         }
     }
 }
 
-// Possible modification: For example, if rec = 0.4, then use 10/25 to test, ie, use random numbers on [0..24] and success if random number is <= 9. Not sure how much performance boost would be obtained. Would only need five bits to generate random number, so could use bit operations on 64 bit random number.
+// Clone classes draw the number of mutant offspring of a class from probMutation(), then mutate each mutant with at least one hit. Number of hits is Poisson conditioned on >= 1, drawn by inversion, so same distribution as mutate() given that it changes the genotype. Clone classes require stoch == false, so stochast not mutated.
 
-void SetBabyGenotype(Individual& Parent1, Individual& Parent2, Individual& baby)
+double Individual::probMutation()
 {
-    auto& g1 = Parent1.genotype;
-    auto& g2 = Parent2.genotype;
-    auto& gb = baby.genotype;
-    auto& s1 = Parent1.stochast;
-    auto& s2 = Parent2.stochast;
-    auto& sb = baby.stochast;
-    ulong chrFlag = rnd.rbit();        // determines which parent is used for copying
+    return (mutLocus >= 0) ? mut : -expm1(-mut*totalLoci);
+}
 
-    for (int i = 0; i < Parent1.totalLoci; ++i){
-        gb[i] = (chrFlag) ? g1[i] : g2[i];
-        if (Individual::stoch) sb[i] = (chrFlag) ? s1[i] : s2[i];
-        if (rnd.rU01() < baby.rec) chrFlag ^= 1;        // flip flag if recombination at rate 0.5
+void Individual::mutateForced()
+{
+    if (mutLocus >= 0){
+        genotype[mutLocus] = mutateStep(genotype[mutLocus]);
+        return;
+    }
+    double lambda = mut*totalLoci;
+    double pk = lambda/expm1(lambda);           // P(hits = 1 | hits >= 1)
+    auto& r = *rndStreams.vary;
+    double u = r.rU01() - pk;
+    int hits = 1;
+    while (u > 0.0 && pk > 0.0){                // pk underflow ends rounding tail
+        ++hits;
+        pk *= lambda/hits;
+        u -= pk;
+    }
+    for (int i = 0; i < hits; ++i){
+        ulong locus = r.rtop(totalLoci);
+        genotype[locus] = mutateStep(genotype[locus]);
+    }
+}
+
+// Recombination builds a crossover mask for the whole genome, bit i of crossMask set => locus i from Parent1, then blends parents without branches. Stochast alleles are linked to genotype alleles, so use same mask.
+
+// Crossover events: bit b set => parent switches between loci b-1 and b. For rec >= 1/1024, compare 16 bit lanes of random words to threshold rec*2^16, 4 loci per word, so cost independent of rec and no branches. For smaller rec, 16 bit lanes too coarse, jump between crossover events by geometric skips, cost is one uniform per event and events are rare. Mask is prefix xor of events, ie, parity of number of events up to each locus.
+
+void Individual::setCrossMask(ulong chrFlag)
+{
+    auto& r = *rndStreams.vary;
+    for (auto& w : crossMask) w = 0;
+    if (recSkip){
+        double pos = 0.0;
+        while (true){
+            double u = r.rU01();
+            pos += 1.0 + ((u > 0.0) ? floor(log(u)*invLogNoRec) : static_cast<double>(totalLoci));
+            if (pos >= totalLoci) break;
+            auto b = static_cast<ulong>(pos);
+            crossMask[b >> 6] |= 1ul << (b & 63);
+        }
+    }
+    else{
+        for (int b = 1; b < totalLoci; b += 4){
+            uint64_t bits = r.rawint();
+            for (int k = 0; k < 4 && b + k < totalLoci; ++k){
+                int pos = b + k;
+                uint64_t hit = ((bits >> (16*k)) & 0xffff) < recThreshold;
+                crossMask[pos >> 6] |= hit << (pos & 63);
+            }
+        }
+    }
+    uint64_t carry = (chrFlag) ? ~0ul : 0ul;
+    for (auto& w : crossMask){
+        w ^= w << 1; w ^= w << 2; w ^= w << 4;
+        w ^= w << 8; w ^= w << 16; w ^= w << 32;
+        w ^= carry;
+        carry = (w >> 63) ? ~0ul : 0ul;
     }
+}
+
+// Loop has no branches on mask, compiler can vectorize; one mask word per block of 64 loci, so inner loop has fixed mask and stride one for polygenic genomes
+
+void Individual::blendParents(const Allele *a1, const Allele *a2, Allele *ab)
+{
+    static_assert(sizeof(Allele) == sizeof(uint32_t), "blend assumes 32 bit Allele");
+    for (int b = 0; b < totalLoci; b += 64){
+        uint64_t m = crossMask[b >> 6];
+        int n = std::min(64, totalLoci - b);
+        for (int k = 0; k < n; ++k){
+            uint32_t sel = 0u - static_cast<uint32_t>((m >> k) & 1);
+            uint32_t u1, u2;
+            std::memcpy(&u1, a1 + b + k, sizeof u1);
+            std::memcpy(&u2, a2 + b + k, sizeof u2);
+            uint32_t u = (u1 & sel) | (u2 & ~sel);
+            std::memcpy(ab + b + k, &u, sizeof u);
+        }
+    }
+}
+
+// Baby from crossMask: alleles and trait values in polygenic mode, else genotype; stochast linked to genotype
+
+void Individual::crossParents(Individual& parent1, Individual& parent2, Individual& baby)
+{
+    if (polyLoci > 1){
+        blendParents(parent1.alleles.get(), parent2.alleles.get(), baby.alleles.get());
+        baby.sumTraits(parent1, parent2);
+    }
+    else
+        blendParents(parent1.genotype.get(), parent2.genotype.get(), baby.genotype.get());
+    if (stoch)
+        blendParents(parent1.stochast.get(), parent2.stochast.get(), baby.stochast.get());
+}
+
+// 1 if bits lo..hi-1 of crossMask all set, 0 if none set, -1 if mixed
+
+int Individual::maskRun(int lo, int hi)
+{
+    bool any = false, all = true;
+    for (int w = lo >> 6; w <= (hi - 1) >> 6; ++w){
+        uint64_t m = ~0ul;
+        if (w == lo >> 6) m &= ~0ul << (lo & 63);
+        if (w == (hi - 1) >> 6) m &= ~0ul >> (63 - ((hi - 1) & 63));
+        uint64_t bits = crossMask[static_cast<size_t>(w)] & m;
+        any = any || bits != 0;
+        all = all && bits == m;
+    }
+    return (all) ? 1 : ((any) ? -1 : 0);
+}
+
+// Trait values after crossover of alleles, see Individual.h
+
+void Individual::sumTraits(const Individual& parent1, const Individual& parent2)
+{
+    for (int t = 0; t < traits; ++t){
+        // with mutLocus, other traits never mutate, so both parents have the same alleles and exact initial value
+        int run = (mutLocus >= 0 && t != mutLocus) ? 1 : maskRun(t*polyLoci, (t + 1)*polyLoci);
+        if (run >= 0){
+            const Individual& p = (run) ? parent1 : parent2;
+            traitSum[t] = p.traitSum[t];
+            genotype[t] = p.genotype[t];
+            continue;
+        }
+        const Allele *a = alleles.get() + t*polyLoci;
+        double sum = 0.0;
+        for (int j = 0; j < polyLoci; ++j) sum += a[j];
+        traitSum[t] = sum;
+        genotype[t] = static_cast<Allele>(sum);
+    }
+}
+
+void SetBabyGenotype(Individual& Parent1, Individual& Parent2, Individual& baby)
+{
+    Individual::setCrossMask(rndStreams.vary->rbit());       // first bit determines which parent starts
+    Individual::crossParents(Parent1, Parent2, baby);
     baby.fitness = baby.calcFitness();
 }
 
 // This routine applies when -log2(rec) is integer 0,1,2,...
 // rec = 1 => -log2 rec = 0 is OK here, each successive locus chosen from alternate parent
 // assumes that random integer has random bits
+// Uses same random bits as before mask blending was introduced, so results unchanged
 
 void SetBabyGenotypeLogRec(Individual& Parent1, Individual& Parent2, Individual& baby)
 {
-    auto& g1 = Parent1.genotype;
-    auto& g2 = Parent2.genotype;
-    auto& gb = baby.genotype;
-    auto& s1 = Parent1.stochast;
-    auto& s2 = Parent2.stochast;
-    auto& sb = baby.stochast;
-    ulong rawint = rnd.rawint();
+    auto& cm = Individual::crossMask;
+    auto& r = *rndStreams.vary;
+    ulong rawint = r.rawint();
     ulong recShift = Individual::negLog2Rec; // -log 2 rec, w/rec = (1/2, 1/4, 1/8, ...), set in Popul
     ulong mask = (1 << recShift) - 1;        // e.g., recShift = 2 => mask = 00...0011, ie, low two bits
     ulong chrFlag = rawint & 1;              // determines initial parent w/prob = 1/2, ie, random bit
-    auto rbits = rnd.bitSize() - recShift;   // remaining bits available
+    auto rbits = r.bitSize() - recShift;   // remaining bits available
     
+    for (auto& w : cm) w = 0;
     for (int i = 0; i < Parent1.totalLoci; ++i){
-        gb[i] = (chrFlag) ? g1[i] : g2[i];
-        if (Individual::stoch) sb[i] = (chrFlag) ? s1[i] : s2[i];
+        cm[i >> 6] |= chrFlag << (i & 63);
         rawint >>= recShift;                            // move used bits out
-        if ((rawint & mask) == mask) chrFlag ^= 1;      // flip flag if recombination
+        chrFlag ^= ((rawint & mask) == mask);           // flip flag if recombination
         if ((rbits -= recShift) == 0){                  // reload random bits if all used up
-            rawint = rnd.rawint();                      // new random int
-            rbits = rnd.bitSize();                      // reset remaining bits left to use
+            rawint = r.rawint();                        // new random int
+            rbits = r.bitSize();                        // reset remaining bits left to use
         }
     }
+    Individual::crossParents(Parent1, Parent2, baby);
     baby.fitness = baby.calcFitness();
 }
 
@@ -209,58 +500,34 @@ void SetBabyGenotypeLogRec(Individual& Parent1, Individual& Parent2, Individual&
 
 void SetBabyGenotypeNoRec(Individual& Parent, Individual& Unused __attribute__((unused)), Individual& baby)
 {
-    for (int i = 0; i < Parent.totalLoci; ++i){
+    for (int i = 0; i < Individual::traits; ++i){
         baby.genotype[i] = Parent.genotype[i];
         if (Individual::stoch) baby.stochast[i] = Parent.stochast[i];
     }
+    if (Individual::polyLoci > 1){
+        std::memcpy(baby.alleles.get(), Parent.alleles.get(), static_cast<size_t>(Individual::totalLoci)*sizeof(Allele));
+        std::memcpy(baby.traitSum.get(), Parent.traitSum.get(), static_cast<size_t>(Individual::traits)*sizeof(double));
+    }
     baby.fitness = baby.calcFitness();
 }
 
-// Calculation of num and den take from openVclose.h in pagmo optimization code; assumes dentilde = den, ie, not studying role of variable plant w/regard to stability margin. Plant set, see manuscripts. Plant parameters do not vary, thus a is set to optimal value of a = sqrt(1 + gamma), and optimal value of J = sqrt(gamma).
-// Forms for num and den in MMA file
+// J and fitness computed by EvalJ and EvalFitness, see Evaluate.h
 
 double Individual::calcJ()
 {
-    double tmax = 20.0;
-    double a = sqrt(1+gamma);
-    if (abs(aSD) > 1e-6) a *= pow(2.0,rnd.normal(0,aSD));   // a = a*2^x, x ~ N(0,aSD)
-    // p0 = 0 by assumption
-    double p1 = genotype[0] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[0])) : 1.0);
-    double p2 = genotype[1] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[1])) : 1.0);
-    double q0 = genotype[2] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[2])) : 1.0);
-    double q1 = genotype[3] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[3])) : 1.0);
-    double q2 = genotype[4] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[4])) : 1.0);
-    double r, k;
-    if (loop == Loop::dclose){
-        r = genotype[5] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[5])) : 1.0);
-        k = genotype[6] * ((stoch) ? pow(2.0,rnd.normal(0,stochWt*stochast[6])) : 1.0);
-    }
-    std::vector<double> num;
-    std::vector<double> den;
-    switch (loop){
-        case Loop::open:
-            num = {q2,q1,q0};
-            den = {p2, p1+a*p2, a*p1 + p2, p1};
-            break;
-        case Loop::close:
-            num = {q2,q1,q0};
-            den = {p2+q2, p1+a*p2+q1, a*p1+p2+q0, p1};
-            break;
-        case Loop::dclose:
-            double rk = r*k;
-            num = {rk*q2, rk*q1 + k*q2, rk*q0 + k*q1, k*q0};
-            den = {rk*q2, p2 + rk*q1 + q2 + k*q2, p1 + a*p2 + rk*q0 + q1 + k*q1,
-                a*p1 + p2 + q0 + k*q0, p1};
-            break;
-    }
-    
-    return performance(num, den, gamma, tmax, signalType::output);
+    if (jTable.isOn()) return jTable.getJ(genotype[mutLocus]);
+    if (surrogate.isOn()) return surrogate.getJ(genotype.get(), [this]{return calcJExact();});
+    return calcJExact();
+}
+
+double Individual::calcJExact()
+{
+    ++exactEvals;
+    return EvalJ(genotype.get(), stochast.get(), evalParam, *rndStreams.perturb);
 }
 
 double Individual::calcFitness()
 {
-    double optJ = sqrt(gamma);
-    double Jdev = (calcJ()/optJ) - 1.0;
-    return fitness = exp(-(Jdev*Jdev)/(2*fitVar));
+    return fitness = EvalFitness(calcJ(), evalParam);
 }
 
@@ -4,6 +4,9 @@
 #include APPL_H
 #include "typedefs.h"
 #include "Individual.h"
+#include "JTable.h"
+#include "Surrogate.h"
+#include "Evaluate.h"
 
 // Use array of floats for genotype.
 
@@ -14,6 +17,8 @@
 // Make global parameters as static variables for class, so can access them without always passing Param
 // Static variables must be declared in Individual.cc, and values initialized by main program
 
+// Polygenic mode, param polyLoci > 1: each trait, a controller parameter, is the sum of polyLoci additive loci, held in alleles, trait by trait, so the loci of a trait are adjacent on the chromosome. genotype then holds the trait values, which EvalJ, statistics and all analyses read as before, so their cost does not grow with polyLoci. Crossover blends alleles over the whole genome by mask, and a trait whose loci all come from one parent copies that parent's value, so only traits with a crossover inside are summed again. Mutation is sparse, a Poisson number of hits over the genome, and each hit adds its change to its trait, so cost is O(hits). Each mutational step is mutStep / sqrt(polyLoci), so mutational variance of a trait is about that of one locus with step mutStep. Running sums of each trait are kept in double in traitSum, and genotype holds them rounded to Allele, so drift from exact sums by rounding of increments is about 1e-16 of the value per mutation along a lineage, negligible also without recombination, where traits are never summed again. With mutLocus, other traits keep their exact initial value, as JTable assumes, through crossover too. Needs stochWt = 0, geneal = 0, and disables clone classes, checked in GetParam and LifeCycle.
+
 // stochast is array of phenotypic stochasticity Alleles, with one-to-one map of stochasticity to genotype alleles. For recombination, stochast alleles linked to genotype alleles, ie, no recombination between each genotype and its associated stochasticity allele. Value of stochast is standard deviation of Gaussian fluctuations, each fluctuation weighted by param stochWt. If stochWt == 0, then param stoch = false and ignore.
 
 class Individual;
@@ -37,21 +42,47 @@ public:
     Individual(const Individual& other);                // copy constructor
     Individual&     operator=(const Individual& other); // assignment constructor
     static void     setParam(Param& param);             // set static variables for class
+    static void     setJTable(Param& param);            // build table of J if single-locus deterministic, else clear
+    static auto&    getJTable(){return jTable;}
+    static void     setSurrogate(Param& param);         // surrogate for J if multi-locus deterministic, else clear
+    static auto&    getSurrogate(){return surrogate;}
+    static auto&    getEvalParam(){return evalParam;}
     void            setNegLog2Rec(ulong r) {negLog2Rec = r;};
     void			initialize();
+    void            setInitialGenotype();
+    void            setInitialGenotypeOrder();
+    static std::vector<Allele> initialGenotypeOrder(const EvalParam& ep);   // start for orders other than 2, 2
+    static bool     initialOrderStable(const EvalParam& ep, SAFrand_pcg<pcgT>& r);  // check of that start, for GetParam
+    void            allocate();
     void			mutate();
+    void            mutatePoly();
     void            mutateG(std::unique_ptr<Allele []>&, bool);
+    void            mutateForced();                     // at least one hit, genotype only, see ClonePopulation.h
+    static double   probMutation();                     // probability that mutate() hits at least one locus
     auto            getRecombination(){return rec;}
     void            setRecombination(double r){rec = r;}
     double          calcJ();
+    double          calcJExact();
+    static uint64_t takeExactEvals(){auto e = exactEvals; exactEvals = 0; return e;}  // calcJExact calls since last call, for Status
     double			calcFitness();
     double          getFitness(){return fitness;};
+    void            setFitness(double f){fitness = f;}
     auto&           getGenotype(){return genotype;};
     auto&           getStochast(){return stochast;};
+    auto&           getAlleles(){return alleles;};      // polygenic loci, null unless polyLoci > 1
+    auto&           getTraitSums(){return traitSum;};   // polygenic trait sums, null unless polyLoci > 1
+    static int      getTotalLoci(){return totalLoci;}
+    int             getNode(){return node;}
+    void            setNode(int n){node = n;}
+    static auto&    getCrossMask(){return crossMask;}
+    static void     setLogMutations(bool b){logMut = b; mutLog.clear();}
+    static auto&    getMutLog(){return mutLog;}
     Allele          mutateStep(Allele a);
 private:
     static double	mut;            // per genome mutation rate, param.mutation is per locus mutation rate
-    static int		totalLoci;
+    static int		totalLoci;      // loci of genome, traits * polyLoci
+    static int      traits;         // param.loci, size of genotype and stochast
+    static int      polyLoci;       // loci per trait, > 1 => polygenic mode
     static double   rec;            // recombination probability
     static ulong    negLog2Rec;     // -log2 recombination, used when rec = 1, 1/2, 1/4, ...
     static Allele   mutStep;        // size of mutational step
@@ -62,9 +93,28 @@ private:
     static int      mutLocus;       // if >= 0, then mutate only this locus
     static double   stochWt;        // weighting of stochastic fluctuations
     static bool     stoch;          // (stochWt == 0) ? false : true
+    static bool     recSkip;        // small rec => geometric skips between crossovers, else threshold on 16 bit lanes
+    static uint32_t recThreshold;   // rec * 2^16
+    static double   invLogNoRec;    // 1/log(1-rec), for geometric skips
+    static std::vector<uint64_t> crossMask;  // bit i set => locus i from Parent1, see SetBabyGenotype
+    static void     setCrossMask(ulong chrFlag);
+    static void     blendParents(const Allele *a1, const Allele *a2, Allele *ab);
+    static void     crossParents(Individual& parent1, Individual& parent2, Individual& baby);
+    static int      maskRun(int lo, int hi);
+    void            sumTraits(const Individual& parent1, const Individual& parent2);
+    static JTable   jTable;         // J as function of allele at mutLocus, see JTable.h
+    static Surrogate surrogate;     // local model of J over genotypes, see Surrogate.h
+    static EvalParam evalParam;     // copy of parameters above for EvalJ, see Evaluate.h
     std::unique_ptr<Allele[]> genotype;
     std::unique_ptr<Allele[]> stochast;  // phenotypic stochasticity
+    std::unique_ptr<Allele[]> alleles;   // polygenic mode, locus j of trait t at t * polyLoci + j
+    std::unique_ptr<double[]> traitSum;  // polygenic mode, sum of alleles of trait t, genotype[t] is its rounded value
     double          fitness;
+    int             node = -1;      // genealogy node id, see Genealogy.h
+    struct MutLog {int locus; bool stoch; Allele value;};
+    static bool     logMut;         // record mutations in mutLog, used for genealogy
+    static std::vector<MutLog> mutLog;
+    static uint64_t exactEvals;     // calls of calcJExact, not answered by J table or surrogate
 };
 
 #endif
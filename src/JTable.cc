@@ -0,0 +1,114 @@
+#include <cmath>
+
+#include "JTable.h"
+
+// Start with 17 nodes over center +/- halfWidth, then refine
+
+void JTable::build(std::function<double(Allele)> exactJ, Allele center, Allele halfWidth, double errTol)
+{
+    exact = exactJ;
+    tol = errTol;
+    h = halfWidth / 8.0;
+    lo = center - halfWidth;
+    J = std::vector<double>(17);
+    for (unsigned i = 0; i < J.size(); ++i)
+        J[i] = exact(static_cast<Allele>(lo + i*h));
+    lookups = misses = spotChecks = 0;
+    maxSpotErr = 0.0;
+    refine();
+    on = true;
+}
+
+// Evaluate exact J at midpoints of current grid and compare with interpolated value, then merge midpoints into grid. Stop when max error of the coarser grid is below tol, so the finer grid that is kept is conservative. Midpoints at which system is unstable are discontinuities of J, become unstable nodes and are excluded from the error.
+
+void JTable::refine()
+{
+    double err;
+    do {
+        auto n = J.size();
+        std::vector<double> fine(2*n - 1);
+        err = 0.0;
+        for (unsigned i = 0; i < n; ++i)
+            fine[2*i] = J[i];
+        for (unsigned i = 0; i < n - 1; ++i){
+            double mid = exact(static_cast<Allele>(lo + (i + 0.5)*h));
+            fine[2*i+1] = mid;
+            if (i >= 1 && i + 2 < n && mid < unstableJ && stableStencil(i))
+                err = std::max(err, std::abs(interpolate(0.5, i) - mid));
+        }
+        J = std::move(fine);
+        h /= 2.0;
+    } while (err > tol && 2*J.size() - 1 <= maxNodes);
+    if (err > tol && showProgress)
+        std::cout << fmt::format("JTable: max nodes reached, interpolation error {:.3e} > {:.3e}\n", err, tol);
+}
+
+double JTable::getJ(Allele x)
+{
+    ++lookups;
+    double u = (x - lo) / h;
+    if (!std::isfinite(u)){
+        ++misses;
+        return exact(x);
+    }
+    auto i = static_cast<long>(floor(u));
+    auto n = static_cast<long>(J.size());
+    if (i < 1 || i + 2 >= n){
+        extend(i);
+        u = (x - lo) / h;
+        i = static_cast<long>(floor(u));
+        n = static_cast<long>(J.size());
+        if (i < 1 || i + 2 >= n){     // extension would exceed maxNodes
+            ++misses;
+            return exact(x);
+        }
+    }
+    if (!stableStencil(i)){
+        ++misses;
+        return exact(x);
+    }
+    double y = interpolate(u - static_cast<double>(i), i);
+    if (lookups % spotEvery == 0){
+        ++spotChecks;
+        maxSpotErr = std::max(maxSpotErr, std::abs(exact(x) - y));
+    }
+    return y;
+}
+
+// Grow grid by at least half its size on the side needed, so that nodes i-1..i+2 exist
+
+void JTable::extend(long i)
+{
+    auto n = static_cast<long>(J.size());
+    long k;
+    if (i < 1)
+        k = std::max(1 - i, n/2);
+    else
+        k = std::max(i + 3 - n, n/2);
+    if (n + k > static_cast<long>(maxNodes)) return;
+    std::vector<double> added(k);
+    if (i < 1){
+        lo -= static_cast<double>(k)*h;
+        for (long j = 0; j < k; ++j)
+            added[j] = exact(static_cast<Allele>(lo + static_cast<double>(j)*h));
+        J.insert(J.begin(), added.begin(), added.end());
+    }
+    else{
+        for (long j = 0; j < k; ++j)
+            added[j] = exact(static_cast<Allele>(lo + static_cast<double>(n + j)*h));
+        J.insert(J.end(), added.begin(), added.end());
+    }
+}
+
+bool JTable::stableStencil(long i)
+{
+    return J[i-1] < unstableJ && J[i] < unstableJ && J[i+1] < unstableJ && J[i+2] < unstableJ;
+}
+
+// Catmull-Rom cubic through nodes i-1..i+2, t in [0,1) is position between nodes i and i+1
+
+double JTable::interpolate(double t, long i)
+{
+    double p0 = J[i-1], p1 = J[i], p2 = J[i+1], p3 = J[i+2];
+    return 0.5*(2.0*p1 + t*((p2 - p0) + t*((2.0*p0 - 5.0*p1 + 4.0*p2 - p3) + t*(3.0*(p1 - p2) + p3 - p0))));
+}
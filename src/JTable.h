@@ -0,0 +1,46 @@
+#ifndef _JTable_h
+#define _JTable_h 1
+
+#include <functional>
+#include <vector>
+
+#include APPL_H
+#include "typedefs.h"
+
+// Tabulated performance J for single-locus mutation mode. With mutLocus >= 0, aSD == 0 and stochWt == 0, J is a deterministic function of the allele at mutLocus, so compute J exactly on a uniform grid of allele values and then interpolate with a cubic through the four nearest nodes.
+
+// Grid spacing is halved until the interpolation error at the midpoints of the current grid is below errTol. The grid extends on demand when an allele wanders past either end. Nodes at which the system is unstable (J = 1e20) are never used for interpolation, fall back to exact value. Every spotEvery lookups, compare against exact value and track the error.
+
+class JTable
+{
+public:
+    void        build(std::function<double(Allele)> exactJ, Allele center, Allele halfWidth, double errTol);
+    void        clear(){on = false; J.clear();}
+    bool        isOn(){return on;}
+    double      getJ(Allele x);
+    auto        getNodes(){return J.size();}
+    auto        getLookups(){return lookups;}
+    auto        getMisses(){return misses;}
+    auto        getSpotChecks(){return spotChecks;}
+    double      getMaxSpotErr(){return maxSpotErr;}
+private:
+    double      interpolate(double u, long i);
+    bool        stableStencil(long i);
+    void        refine();
+    void        extend(long i);
+    std::function<double(Allele)> exact;
+    std::vector<double> J;      // J at grid nodes, node i at allele value lo + i*h
+    double      lo;             // allele value of first node
+    double      h;              // grid spacing
+    double      tol;            // max interpolation error
+    bool        on = false;
+    ulong       lookups;
+    ulong       misses;         // lookups evaluated exactly because stencil was unstable
+    ulong       spotChecks;
+    double      maxSpotErr;
+    static constexpr ulong  spotEvery = 1000;
+    static constexpr ulong  maxNodes = 1 << 16;
+    static constexpr double unstableJ = 1e19;   // performance() returns 1e20 for unstable systems
+};
+
+#endif
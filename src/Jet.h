@@ -0,0 +1,97 @@
+#ifndef _Jet_h
+#define _Jet_h 1
+
+#include <cmath>
+
+// Second order forward mode differentiation. A Jet carries value v, gradient g and Hessian h with respect to Jet::vars independent variables; h is the upper triangle, row by row, h[k] for (i, j), i <= j, in loop order i then j. Arithmetic applies the chain rule to all three, so one evaluation of a function over Jets gives its value, gradient and Hessian exactly, up to rounding, without differences. Storage has fixed capacity maxJetVars, so Jets are plain values without allocation; operations loop over the vars in use only. vars is per thread and must not change while Jets of a computation are alive.
+
+// Branches of the evaluated code follow values, so derivatives are those of the branch taken, for example of the steps an adaptive integrator chose.
+
+const int maxJetVars = 7;
+const int maxJetHess = maxJetVars*(maxJetVars + 1)/2;
+
+class Jet
+{
+public:
+    Jet(double x = 0.0) : v(x), g{}, h{} {}
+    static Jet variable(double x, int i){Jet a(x); a.g[i] = 1.0; return a;}
+    static void setVars(int n){vars = n;}
+    static int getVars(){return vars;}
+    static int hessSize(){return vars*(vars + 1)/2;}
+
+    double v;
+    double g[maxJetVars];
+    double h[maxJetHess];
+
+    // f(x) given f, f', f'' at x.v
+    Jet chain(double f0, double f1, double f2) const
+    {
+        Jet r(f0);
+        for (int i = 0, k = 0; i < vars; ++i){
+            r.g[i] = f1*g[i];
+            for (int j = i; j < vars; ++j, ++k) r.h[k] = f1*h[k] + f2*g[i]*g[j];
+        }
+        return r;
+    }
+    Jet& operator+=(const Jet& b)
+    {
+        v += b.v;
+        for (int i = 0; i < vars; ++i) g[i] += b.g[i];
+        for (int k = 0, n = hessSize(); k < n; ++k) h[k] += b.h[k];
+        return *this;
+    }
+    Jet& operator-=(const Jet& b)
+    {
+        v -= b.v;
+        for (int i = 0; i < vars; ++i) g[i] -= b.g[i];
+        for (int k = 0, n = hessSize(); k < n; ++k) h[k] -= b.h[k];
+        return *this;
+    }
+    Jet& operator*=(double c)
+    {
+        v *= c;
+        for (int i = 0; i < vars; ++i) g[i] *= c;
+        for (int k = 0, n = hessSize(); k < n; ++k) h[k] *= c;
+        return *this;
+    }
+    Jet& operator*=(const Jet& b)
+    {
+        for (int i = 0, k = 0; i < vars; ++i)
+            for (int j = i; j < vars; ++j, ++k)
+                h[k] = h[k]*b.v + v*b.h[k] + g[i]*b.g[j] + g[j]*b.g[i];
+        for (int i = 0; i < vars; ++i) g[i] = g[i]*b.v + v*b.g[i];
+        v *= b.v;
+        return *this;
+    }
+    Jet& operator/=(const Jet& b){return *this *= b.chain(1.0/b.v, -1.0/(b.v*b.v), 2.0/(b.v*b.v*b.v));}
+    Jet& operator+=(double c){v += c; return *this;}
+    Jet& operator-=(double c){v -= c; return *this;}
+    Jet& operator/=(double c){return *this *= 1.0/c;}
+private:
+    inline static thread_local int vars = 0;
+};
+
+inline Jet operator+(Jet a, const Jet& b){return a += b;}
+inline Jet operator-(Jet a, const Jet& b){return a -= b;}
+inline Jet operator*(Jet a, const Jet& b){return a *= b;}
+inline Jet operator/(Jet a, const Jet& b){return a /= b;}
+inline Jet operator+(Jet a, double c){return a += c;}
+inline Jet operator-(Jet a, double c){return a -= c;}
+inline Jet operator*(Jet a, double c){return a *= c;}
+inline Jet operator/(Jet a, double c){return a /= c;}
+inline Jet operator+(double c, Jet a){return a += c;}
+inline Jet operator-(double c, Jet a){a *= -1.0; return a += c;}
+inline Jet operator*(double c, Jet a){return a *= c;}
+inline Jet operator/(double c, const Jet& a){return a.chain(c/a.v, -c/(a.v*a.v), 2.0*c/(a.v*a.v*a.v));}
+inline Jet operator-(Jet a){return a *= -1.0;}
+
+inline Jet exp(const Jet& a){double e = std::exp(a.v); return a.chain(e, e, e);}
+inline Jet sqrt(const Jet& a){double s = std::sqrt(a.v); return a.chain(s, 0.5/s, -0.25/(s*a.v));}
+inline Jet pow(const Jet& a, double p)
+    {return a.chain(std::pow(a.v, p), p*std::pow(a.v, p - 1.0), p*(p - 1.0)*std::pow(a.v, p - 2.0));}
+
+// value of double or Jet, for branches and error control in code templated on either
+inline double Value(double x){return x;}
+inline double Value(const Jet& x){return x.v;}
+
+#endif
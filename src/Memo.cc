@@ -0,0 +1,144 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+
+#include "Memo.h"
+
+const char memoMagic[8] = {'s', 'e', 'n', 's', 'm', 'e', 'm', '1'};
+const uint32_t recordMagic = 0x6d656d6f;
+
+static_assert(sizeof(rndType) <= sizeof(uint64_t), "seed must fit record field");
+
+// checksum of sources, see Makefile; without it, every build shares one version, so clear memo file by hand
+#ifdef CODE_VERSION
+#define MEMO_STR(x) #x
+#define MEMO_XSTR(x) MEMO_STR(x)
+const std::string codeVersion = MEMO_XSTR(CODE_VERSION);
+#else
+const std::string codeVersion = "unversioned";
+#endif
+
+ResultMemo::ResultMemo(const std::string& name) : filename(name)
+{
+    fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        ThrowError(__FILE__, __LINE__, "Could not open " + filename + ": " + strerror(errno));
+    flock(fd, LOCK_EX);
+    struct stat st;
+    fstat(fd, &st);
+    auto size = static_cast<size_t>(st.st_size);
+    if (size == 0){
+        if (pwrite(fd, memoMagic, sizeof(memoMagic), 0) != static_cast<ssize_t>(sizeof(memoMagic))){
+            flock(fd, LOCK_UN);
+            ThrowError(__FILE__, __LINE__, "Could not write header of " + filename);
+        }
+        size = sizeof(memoMagic);
+    }
+    map(size);
+    if (memcmp(base, memoMagic, sizeof(memoMagic)) != 0){
+        flock(fd, LOCK_UN);
+        ThrowError(__FILE__, __LINE__, filename + " is not a result memo file");
+    }
+    // index complete records, drop a partial record at the end
+    end = sizeof(memoMagic);
+    while (end + sizeof(Record) <= size){
+        Record r;
+        memcpy(&r, base + end, sizeof(Record));
+        size_t next = end + sizeof(Record) + r.keyLen + r.resultLen;
+        if (r.magic != recordMagic || next > size || next < end) break;
+        index.emplace(hash(std::string(base + end + sizeof(Record), r.keyLen)), end);
+        ++records;
+        end = next;
+    }
+    if (end < size){
+        if (ftruncate(fd, static_cast<off_t>(end)) != 0){
+            flock(fd, LOCK_UN);
+            ThrowError(__FILE__, __LINE__, "Could not truncate partial record of " + filename);
+        }
+        map(end);
+    }
+    flock(fd, LOCK_UN);
+}
+
+ResultMemo::~ResultMemo()
+{
+    if (base) munmap(base, mapped);
+    if (fd >= 0) close(fd);
+}
+
+// map first size bytes of file, replacing any earlier mapping
+
+void ResultMemo::map(size_t size)
+{
+    if (base) munmap(base, mapped);
+    void *m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
+        ThrowError(__FILE__, __LINE__, "Could not map " + filename + ": " + strerror(errno));
+    base = static_cast<char *>(m);
+    mapped = size;
+}
+
+// FNV-1a
+
+uint64_t ResultMemo::hash(const std::string& key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key){
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool ResultMemo::find(const std::string& runKey, std::string& result, rndType& nextSeed)
+{
+    std::string key = codeVersion + " " + runKey;
+    auto range = index.equal_range(hash(key));
+    for (auto it = range.first; it != range.second; ++it){
+        Record r;
+        memcpy(&r, base + it->second, sizeof(Record));
+        const char *k = base + it->second + sizeof(Record);
+        if (r.keyLen != key.size() || memcmp(k, key.data(), key.size()) != 0) continue;
+        result.assign(k + r.keyLen, r.resultLen);
+        nextSeed = static_cast<rndType>(r.nextSeed);
+        ++hits;
+        return true;
+    }
+    return false;
+}
+
+void ResultMemo::insert(const std::string& runKey, const std::string& result, rndType nextSeed)
+{
+    std::string key = codeVersion + " " + runKey;
+    Record r = {recordMagic, static_cast<uint32_t>(key.size()), result.size(), static_cast<uint64_t>(nextSeed)};
+    std::string buf(reinterpret_cast<const char *>(&r), sizeof(Record));
+    buf += key;
+    buf += result;
+    // append at current end of file, which other processes may have moved
+    flock(fd, LOCK_EX);
+    struct stat st;
+    fstat(fd, &st);
+    auto at = static_cast<size_t>(st.st_size);
+    size_t done = 0;
+    while (done < buf.size()){
+        auto n = pwrite(fd, buf.data() + done, buf.size() - done, static_cast<off_t>(at + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0){
+            std::string msg = "Error writing " + filename + ": " + strerror(errno);
+            if (ftruncate(fd, static_cast<off_t>(at)) != 0)      // else next open drops partial record
+                msg += ", partial record left";
+            flock(fd, LOCK_UN);
+            ThrowError(__FILE__, __LINE__, msg);
+        }
+        done += static_cast<size_t>(n);
+    }
+    flock(fd, LOCK_UN);
+    map(at + buf.size());
+    index.emplace(hash(key), at);
+    end = at + buf.size();
+    ++records;
+}
@@ -0,0 +1,41 @@
+#ifndef _Memo_h
+#define _Memo_h 1
+
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <cstdint>
+
+#include APPL_H
+
+// Persistent store of run results across experiments, used by main-alone with -m for plain runs. Key is CODE_VERSION, a checksum of the sources set by the Makefile, so a rebuild after any source change misses every old entry, then the text from RunKey: every design and control parameter as read and effective seed. Value is result text of the run and the seed that main draws after it, so the seed chain of later runs is the same whether a run is found or computed.
+
+// File is a header then records appended in order, each a fixed header, key and result. On open, the file is memory mapped and scanned once to index records by 64 bit hash of key; a lookup compares the full key, so hash collisions are harmless. A record cut short by a crash is dropped and the file truncated to the last complete record. Inserts append under an exclusive flock, so runs on several hosts may share a file; records appended by others are seen at the next open. Result text is copied out of the map, so later remaps do not invalidate it.
+
+class ResultMemo
+{
+public:
+    explicit ResultMemo(const std::string& filename);
+    ~ResultMemo();
+    bool        find(const std::string& runKey, std::string& result, rndType& nextSeed);
+    void        insert(const std::string& runKey, const std::string& result, rndType nextSeed);
+    size_t      getRecords(){return records;}
+    size_t      getHits(){return hits;}
+private:
+    struct Record {uint32_t magic; uint32_t keyLen; uint64_t resultLen; uint64_t nextSeed;};
+    void        map(size_t size);
+    uint64_t    hash(const std::string& key);
+    std::string filename;
+    int         fd = -1;
+    char        *base = nullptr;        // mapping of first mapped bytes of file
+    size_t      mapped = 0;
+    size_t      end = 0;                // end of last complete record known to this process
+    std::unordered_multimap<uint64_t, size_t> index;     // hash of key to offset of record
+    size_t      records = 0;
+    size_t      hits = 0;
+};
+
+// Key of the run in parmBuf, same layout as for Control, and its runNum, which the key leaves out so that results carry over between experiments; empty if the run is not memoized. Defined in sensitivity.cc, next to GetParam.
+std::string RunKey(std::istringstream& parmBuf, int& runNum);
+
+#endif
@@ -0,0 +1,205 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+
+#include "Numa.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+    int     pinnedCpu = -1;
+    int     node = -1;
+    bool    hugeOn = false;
+    std::vector<int> nodeCpus;
+}
+
+#ifdef __linux__
+
+const int mpolPreferred = 1;        // MPOL_PREFERRED of numaif.h
+const size_t hugePage = 2 << 20;    // smaller ranges cannot fill a huge page, so no advice
+
+// cpu list of form 0-3,8,10-11 as in /sys
+
+std::vector<int> ParseCpuList(const std::string& s)
+{
+    std::vector<int> cpus;
+    std::istringstream in(s);
+    std::string part;
+    while (std::getline(in, part, ',')){
+        auto dash = part.find('-');
+        int lo = std::stoi(part);
+        int hi = (dash == std::string::npos) ? lo : std::stoi(part.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// node whose cpulist contains cpu, 0 if the kernel shows no nodes
+
+int CpuNode(int cpu, std::vector<int>& cpus)
+{
+    for (int n = 0; ; ++n){
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+        if (!in) break;
+        std::string s;
+        std::getline(in, s);
+        auto list = ParseCpuList(s);
+        if (std::find(list.begin(), list.end(), cpu) != list.end()){
+            cpus = list;
+            return n;
+        }
+    }
+    cpus.clear();
+    for (int c = 0; c < static_cast<int>(std::thread::hardware_concurrency()); ++c) cpus.push_back(c);
+    return 0;
+}
+
+int SetAffinity(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto c : cpus) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void PinThread(const std::vector<int>& cpus)
+{
+    int err = SetAffinity(cpus);
+    if (err != 0)
+        ThrowError(__FILE__, __LINE__, std::string("Could not pin thread: ") + strerror(err));
+}
+
+void NumaSetup(int cpu, bool huge)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+        ThrowError(__FILE__, __LINE__, "NUMA cpu out of range");
+    pinnedCpu = cpu;
+    hugeOn = huge;
+    node = CpuNode(cpu, nodeCpus);
+    // keep only cpus the process may use, eg, under a cgroup cpuset, so workers can be pinned to each
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        nodeCpus.erase(std::remove_if(nodeCpus.begin(), nodeCpus.end(),
+                                      [&allowed](int c){return c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed);}),
+                       nodeCpus.end());
+    PinThread({cpu});
+    if (std::find(nodeCpus.begin(), nodeCpus.end(), cpu) == nodeCpus.end()) nodeCpus.push_back(cpu);
+    // policy of this thread, inherited by threads it creates
+    const unsigned long bits = 8*sizeof(unsigned long);
+    std::vector<unsigned long> mask(static_cast<size_t>(node)/bits + 1, 0);
+    mask[static_cast<size_t>(node)/bits] = 1UL << (static_cast<unsigned long>(node) % bits);
+    if (syscall(SYS_set_mempolicy, mpolPreferred, mask.data(), mask.size()*bits + 1) != 0)
+        ThrowError(__FILE__, __LINE__, std::string("Could not set memory policy: ") + strerror(errno));
+}
+
+void NumaPinWorker(unsigned k)
+{
+    if (pinnedCpu < 0) return;
+    PinThread({nodeCpus[k % nodeCpus.size()]});
+}
+
+void NumaWidenThread()
+{
+    if (pinnedCpu < 0) return;
+    SetAffinity(nodeCpus);      // failure leaves thread on pinned cpu, which is slower but correct
+}
+
+void NumaAdvise(const void *p, size_t bytes)
+{
+    if (!hugeOn || bytes < hugePage) return;
+    auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto a = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+    auto b = (reinterpret_cast<uintptr_t>(p) + bytes + page - 1) & ~(page - 1);
+    madvise(reinterpret_cast<void *>(a), b - a, MADV_HUGEPAGE);     // advice only, failure is harmless
+}
+
+void NumaAdviseHeap()
+{
+    if (!hugeOn) return;
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)){
+        if (line.find("[heap]") == std::string::npos) continue;
+        auto dash = line.find('-');
+        auto a = std::stoull(line.substr(0, dash), nullptr, 16);
+        auto b = std::stoull(line.substr(dash + 1), nullptr, 16);
+        madvise(reinterpret_cast<void *>(a), b - a, MADV_HUGEPAGE);
+    }
+}
+
+NumaPages NumaCount(const std::vector<std::pair<const void *, size_t>>& ranges)
+{
+    NumaPages n;
+    if (pinnedCpu < 0) return n;
+    auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::vector<uintptr_t> addr;
+    for (auto& r : ranges){
+        if (r.second == 0) continue;
+        auto a = reinterpret_cast<uintptr_t>(r.first) & ~(page - 1);
+        auto b = reinterpret_cast<uintptr_t>(r.first) + r.second;
+        for (; a < b; a += page) addr.push_back(a);
+    }
+    std::sort(addr.begin(), addr.end());
+    addr.erase(std::unique(addr.begin(), addr.end()), addr.end());
+    std::vector<void *> pages(addr.size());
+    std::vector<int> status(addr.size());
+    for (size_t i = 0; i < addr.size(); ++i) pages[i] = reinterpret_cast<void *>(addr[i]);
+    // nodes null => query only, status is node of page or negative errno
+    if (!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+        ThrowError(__FILE__, __LINE__, std::string("move_pages query failed: ") + strerror(errno));
+    for (auto s : status){
+        if (s < 0) continue;
+        ++n.pages;
+        if (s != node) ++n.remote;
+    }
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    std::string key;
+    while (rollup >> key){
+        if (key == "AnonHugePages:"){
+            rollup >> n.hugeKB;
+            break;
+        }
+    }
+    return n;
+}
+
+#else
+
+void NumaSetup(int, bool)
+{
+    ThrowError(__FILE__, __LINE__, "NUMA placement needs Linux");
+}
+
+void NumaPinWorker(unsigned) {}
+void NumaWidenThread() {}
+void NumaAdvise(const void *, size_t) {}
+void NumaAdviseHeap() {}
+NumaPages NumaCount(const std::vector<std::pair<const void *, size_t>>&) {return NumaPages();}
+
+#endif
+
+bool NumaOn()
+{
+    return pinnedCpu >= 0;
+}
+
+int NumaNode()
+{
+    return node;
+}
+
+std::vector<int> NumaNodeCpus()
+{
+    return nodeCpus;
+}
@@ -0,0 +1,27 @@
+#ifndef _Numa_h
+#define _Numa_h 1
+
+#include <vector>
+#include <utility>
+
+#include APPL_H
+
+// NUMA placement for main-alone -n cpu, Linux only. The compute thread is pinned to cpu and its memory policy prefers the node of cpu, so every later allocation of the process, both populations of LifeCycle and each genotype, is placed on that node when first touched, whichever thread touches it; the process heap is the arena. Several copies of the program on one host each get their own -n. Workers of the robustness pool are pinned to the cpus of the same node, so their batches read local genotypes. Node cpus are those the process may use, so a cgroup cpuset does not make pinning fail. Writer threads of output and population dumps widen to the whole node, so they do not compete with the run for its cpu. Through raw system calls, so no libnuma.
+
+// huge => transparent huge pages advised for population buffers and the heap, see NumaAdvise; pages are huge only if THP is enabled as always or madvise, and khugepaged collapses pages touched before advice.
+
+// Placement is checked, not assumed: NumaCount asks the kernel with move_pages for the node of each page of given ranges, and reports pages and those on another node, in run info as numaPages and numaRemote. Counts are of pages, not of accesses, which would need hardware counters.
+
+struct NumaPages {long pages = 0; long remote = 0; long hugeKB = 0;};
+
+void    NumaSetup(int cpu, bool huge);      // pin calling thread, set memory policy; throws if not Linux or cpu not allowed
+bool    NumaOn();
+int     NumaNode();                         // node of pinned cpu, -1 if off
+std::vector<int> NumaNodeCpus();            // cpus of that node, empty if off
+void    NumaPinWorker(unsigned k);          // pin calling thread to k-th cpu of node, no-op if off
+void    NumaWidenThread();                  // let calling thread run on any cpu of node, for helper threads that would inherit the pin; no-op if off
+void    NumaAdvise(const void *p, size_t bytes);    // huge page advice for range of at least 2 MB, no-op unless huge
+void    NumaAdviseHeap();                   // same for brk heap, where small genotype arrays live
+NumaPages NumaCount(const std::vector<std::pair<const void *, size_t>>& ranges);
+
+#endif
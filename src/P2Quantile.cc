@@ -0,0 +1,67 @@
+#include <cmath>
+#include <algorithm>
+
+#include "P2Quantile.h"
+
+P2Quantile::P2Quantile(double prob) : p(prob)
+{
+    for (int i = 0; i < 5; ++i) n[i] = i;
+    np[0] = 0.0; np[1] = 2.0*p; np[2] = 4.0*p; np[3] = 2.0 + 2.0*p; np[4] = 4.0;
+    dn[0] = 0.0; dn[1] = p/2.0; dn[2] = p; dn[3] = (1.0 + p)/2.0; dn[4] = 1.0;
+}
+
+void P2Quantile::add(double x)
+{
+    if (count < 5){
+        q[count++] = x;
+        if (count == 5) std::sort(q, q + 5);
+        return;
+    }
+    ++count;
+    int k;
+    if (x < q[0]){
+        q[0] = x;
+        k = 0;
+    }
+    else if (x >= q[4]){
+        q[4] = x;
+        k = 3;
+    }
+    else
+        for (k = 0; x >= q[k+1]; ++k);
+    for (int i = k + 1; i < 5; ++i) n[i] += 1.0;
+    for (int i = 0; i < 5; ++i) np[i] += dn[i];
+    // move interior markers toward desired positions by one, if neighbors leave room
+    for (int i = 1; i < 4; ++i){
+        double d = np[i] - n[i];
+        if ((d >= 1.0 && n[i+1] - n[i] > 1.0) || (d <= -1.0 && n[i-1] - n[i] < -1.0)){
+            d = (d > 0.0) ? 1.0 : -1.0;
+            double qp = parabolic(i, d);
+            if (q[i-1] < qp && qp < q[i+1])
+                q[i] = qp;
+            else{
+                int j = i + static_cast<int>(d);
+                q[i] += d*(q[j] - q[i])/(n[j] - n[i]);
+            }
+            n[i] += d;
+        }
+    }
+}
+
+double P2Quantile::parabolic(int i, double d) const
+{
+    return q[i] + d/(n[i+1] - n[i-1])*((n[i] - n[i-1] + d)*(q[i+1] - q[i])/(n[i+1] - n[i])
+                                       + (n[i+1] - n[i] - d)*(q[i] - q[i-1])/(n[i] - n[i-1]));
+}
+
+double P2Quantile::get() const
+{
+    if (count >= 5) return q[2];
+    if (count == 0) return std::nan("");
+    double s[5];
+    std::copy(q, q + count, s);
+    std::sort(s, s + count);
+    double r = p*(count - 1);
+    auto i = static_cast<int>(r);
+    return (i + 1 < count) ? s[i] + (r - i)*(s[i+1] - s[i]) : s[i];
+}
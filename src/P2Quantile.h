@@ -0,0 +1,23 @@
+#ifndef _P2Quantile_h
+#define _P2Quantile_h 1
+
+// Streaming estimate of quantile p by the P^2 algorithm of Jain and Chlamtac (1985). Five markers: min, max, and estimates of quantiles p/2, p, (1+p)/2, whose heights are adjusted by piecewise parabolic interpolation as observations arrive, so memory is fixed for any number of observations. Until five observations, exact quantile of those seen, by linear interpolation.
+
+class P2Quantile
+{
+public:
+    explicit    P2Quantile(double p);
+    void        add(double x);
+    double      get() const;
+    int         getN() const {return count;}
+private:
+    double      parabolic(int i, double d) const;
+    double      p;
+    int         count = 0;
+    double      q[5];           // marker heights
+    double      n[5];           // marker positions
+    double      np[5];          // desired positions
+    double      dn[5];          // increments of desired positions
+};
+
+#endif
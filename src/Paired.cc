@@ -0,0 +1,78 @@
+#include <cmath>
+#include <sstream>
+
+#include "Paired.h"
+
+rndType PairedRuns::seed(const std::string& runLine, rndType next)
+{
+    std::istringstream in(runLine);
+    int runNum;
+    double loop;
+    in >> runNum >> loop;
+    if (in.fail())
+        ThrowError(__FILE__, __LINE__, "Paired runs: could not read runNum and loop");
+    auto l = static_cast<int>(std::lround(loop));
+    if (l < 0 || l > 2)
+        ThrowError(__FILE__, __LINE__, fmt::format("Paired runs: loop {} of run {} not 0, 1 or 2", loop, runNum));
+    std::string key, tok;
+    while (in >> tok) key += tok + " ";
+    auto it = index.find(key);
+    if (it == index.end()){
+        it = index.emplace(key, points.size()).first;
+        points.push_back({key, {}, {}});
+    }
+    auto& pt = points[it->second];
+    auto rep = pt.runNum[l].size();
+    pt.runNum[l].push_back(runNum);
+    pt.y[l].emplace_back();
+    lastPoint = it->second;
+    lastLoop = l;
+    return seeds.emplace(fmt::format("{}#{}", key, rep), next).first->second;
+}
+
+void PairedRuns::record(const std::vector<double>& y)
+{
+    points[lastPoint].y[lastLoop].back() = y;
+}
+
+std::string PairedRuns::report(const std::vector<std::string>& names)
+{
+    const int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    std::string out = "# paired runs across loop types: mean of differences a - b, paired SE, unpaired SE\n";
+    out += fmt::format("{:>6} {:>6} {:>5} {:>5} {:>4}", "runA", "runB", "loopA", "loopB", "n");
+    for (auto& s : names) out += fmt::format(" {:>11} {:>11} {:>11}", s + "D", "SE", "uSE");
+    out += "\n";
+    for (auto& pt : points){
+        for (auto& ab : pairs){
+            int a = ab[0], b = ab[1];
+            size_t n = 0;       // replicates with results for both
+            while (n < pt.y[a].size() && n < pt.y[b].size() && !pt.y[a][n].empty() && !pt.y[b][n].empty()) ++n;
+            if (n == 0) continue;
+            auto N = static_cast<double>(n);
+            out += fmt::format("{:>6} {:>6} {:>5} {:>5} {:>4}", pt.runNum[a][0], pt.runNum[b][0], a, b, n);
+            for (size_t k = 0; k < names.size(); ++k){
+                double md = 0.0, ma = 0.0, mb = 0.0;
+                for (size_t i = 0; i < n; ++i){
+                    md += pt.y[a][i][k] - pt.y[b][i][k];
+                    ma += pt.y[a][i][k];
+                    mb += pt.y[b][i][k];
+                }
+                md /= N;
+                ma /= N;
+                mb /= N;
+                double vd = 0.0, va = 0.0, vb = 0.0;
+                for (size_t i = 0; i < n; ++i){
+                    double d = pt.y[a][i][k] - pt.y[b][i][k] - md;
+                    vd += d*d;
+                    va += (pt.y[a][i][k] - ma)*(pt.y[a][i][k] - ma);
+                    vb += (pt.y[b][i][k] - mb)*(pt.y[b][i][k] - mb);
+                }
+                double se = (n > 1) ? sqrt(vd/(N - 1.0)/N) : -1.0;
+                double use = (n > 1) ? sqrt((va + vb)/(N - 1.0)/N) : -1.0;
+                out += fmt::format(" {:11.4e} {:11.4e} {:11.4e}", md, se, use);
+            }
+            out += "\n";
+        }
+    }
+    return out;
+}
@@ -0,0 +1,35 @@
+#ifndef _Paired_h
+#define _Paired_h 1
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include APPL_H
+
+// Paired runs across loop types. Runs whose lines match except for runNum and loop, tokens 0 and 1, are one design point; the k-th run of each loop type at a design point is replicate k. All runs of a replicate get the seed of its first run, and with pairedStreams each purpose draws the same random numbers in every loop type, so differences between loop types have the replicate noise common to both removed.
+
+// Report, for each design point and pair of loop types with a common replicate: replicates n, then per output the mean of paired differences a - b, its standard error, and the standard error the same difference would have from unpaired runs, which shows the gain from pairing.
+
+// Pairs are kept in memory, so runs of a design point must be in one invocation; after a restart, remaining runs get new seeds.
+
+class PairedRuns
+{
+public:
+    rndType     seed(const std::string& runLine, rndType next);     // seed for run, next if first of its replicate
+    void        record(const std::vector<double>& y);               // outputs of run of last call to seed
+    std::string report(const std::vector<std::string>& names);
+private:
+    struct Point {
+        std::string         key;
+        std::vector<int>    runNum[3];                  // by loop type, index is replicate
+        std::vector<std::vector<double>> y[3];
+    };
+    std::vector<Point>  points;                         // in order of first run
+    std::map<std::string, size_t> index;                // key to point
+    std::map<std::string, rndType> seeds;               // key and replicate to seed
+    size_t      lastPoint = 0;
+    int         lastLoop = 0;
+};
+
+#endif
@@ -7,10 +7,14 @@
 // Bound p1 >= 1e-7 in calling routine
 
 #include <iostream>
+#include <atomic>
 #include <vector>
 #include <cassert>
 #include <string>
 #include <map>
+#include <array>
+#include <cmath>
+#include <algorithm>
 
 #include <gsl/gsl_poly.h>
 #include <gsl/gsl_complex_math.h>
@@ -25,17 +29,61 @@
 #include "fmt/format.h"
 #include "Performance.h"
 
-// steps for interpolation, 5000 comes very close to Mathematica numerical results, check timing
-const int steps = 5000;
+// accuracy of step response and H2, full fidelity steps = 5000 for interpolation comes very close to Mathematica numerical results
+Fidelity fidelity = fullFidelity;
+void setFidelity(const Fidelity& f) {fidelity = f;}
+Fidelity getFidelity() {return fidelity;}
+
+// Tolerances scale linearly; interpolation error of cubic spline falls as steps^-4, so steps shrink slowly. Low qag key uses fewer Gauss-Kronrod points per interval, enough for smooth integrand at coarse tolerance.
+
+Fidelity scaledFidelity(double scale)
+{
+	if (scale <= 1.0) return fullFidelity;
+	Fidelity f = fullFidelity;
+	f.steps = std::max(500, static_cast<int>(fullFidelity.steps / pow(scale, 0.25)));
+	f.odeTol *= scale;
+	f.qagKey = (scale >= 10.0) ? 2 : fullFidelity.qagKey;
+	f.stepTol *= scale;
+	f.h2Tol *= scale;
+	return f;
+}
 
 unsigned debugPerformance = 0;
 void debugPerformanceOn(unsigned d) {debugPerformance=d;}
 
-double 	MaxRootRealPart(const std::vector<double>& coeff);
+stepMethod method = stepMethod::native;
+StepParity parity = {0, 0.0, 0.0};
+std::atomic<unsigned long> stepFailures{0};     // atomic, native integration also runs on EvalBatch workers
+void setStepMethod(stepMethod m) {method = m; parity = {0, 0.0, 0.0}; stepFailures = 0;}
+stepMethod getStepMethod() {return method;}
+StepParity getStepParity() {return parity;}
+unsigned long getStepFailures() {return stepFailures;}
+
 double 	H2sq(const std::vector<double>& num, const std::vector<double>& den);
 double 	integrandH2(double w, void *p);
 int 	deriv (double t, const double x[], double f[], void *p);
-double 	stepPerformance(const std::vector<double>& num, const std::vector<double>& den, double tmax, signalType s);
+double 	stepPerformance(const std::vector<double>& num, const std::vector<double>& den, double tmax, signalType s,
+					unsigned long outTerms);
+double 	stepPerformanceJoint(const std::vector<double>& num, const std::vector<double>& ctrlNum,
+					const std::vector<double>& den, double tmax, signalType ctrlType, double ctrlWt,
+					unsigned long outTerms);
+template <class T>
+void 	stepCoeff(const std::vector<T>& num, const std::vector<T>& den, signalType s,
+					T ycoeff[maxStepDim], unsigned long& ydim, T& yinputCoeff, unsigned long outTerms);
+double 	checkParity(double result, double g);
+double 	stepPerformanceGSL(const std::vector<double>& num, const std::vector<double>& den, double tmax,
+					signalType s, const double ycoeff[], unsigned long ydim, double yinputCoeff);
+template <int N, int K, class T>
+void 	stepPerformanceNative(const std::vector<T>& den, double tmax, const T ycoeff[][maxStepDim],
+					const T yinputCoeff[], T cost[], int nSample, const double *sampleT, double *sampleY);
+template <int K, int N = 2, class T = double>
+bool 	stepNative(unsigned long dim, const std::vector<T>& den, double tmax, const T ycoeff[][maxStepDim],
+					const T yinputCoeff[], T cost[],
+					int nSample = 0, const double *sampleT = nullptr, double *sampleY = nullptr);
+template <int N, class T>
+bool 	lyapunovP(const std::array<std::array<T,N>,N>& A, std::array<std::array<T,N>,N>& P, const T *c = nullptr);
+template <class T, int N = 2>
+bool 	H2sqLyapunov(unsigned long dim, const T c[], const std::vector<T>& den, T& result);
 double 	integrandStep(double y, void *p);
 
 struct my_params {const std::vector<double>& num; const std::vector<double>& den;};
@@ -44,11 +92,11 @@ struct stepParam {gsl_spline *spline; gsl_interp_accel *acc;};
 // Do chopping to set param to zero if close and check bounds before call
 
 double performance(const std::vector<double>& num, const std::vector<double>& den,
-					double gamma, double tmax, signalType s)
+					double gamma, double tmax, signalType s, unsigned long outTerms)
 {
 	if (MaxRootRealPart(den) > -1e-6) return 1e20;
 	if (debugPerformance){
-		double sf = stepPerformance(num, den, tmax, s);
+		double sf = stepPerformance(num, den, tmax, s, outTerms);
 		double hf = H2sq(num,den);
 		std::map<signalType,std::string> signal = 
 			{{signalType::output, "output"}, {signalType::controlOpen,"cntrlO"}, {signalType::controlClosed,"cntrlC"}};
@@ -56,7 +104,52 @@ double performance(const std::vector<double>& num, const std::vector<double>& de
 		return sf + gamma*hf;
 	}
 	else
-		return stepPerformance(num, den, tmax, s) + gamma*H2sq(num,den);
+		return stepPerformance(num, den, tmax, s, outTerms) + gamma*H2sq(num,den);
+}
+
+double performance(const std::vector<double>& num, const std::vector<double>& ctrlNum, const std::vector<double>& den,
+					double gamma, double tmax, signalType ctrlType, double ctrlWt, unsigned long outTerms)
+{
+	if (ctrlWt == 0.0) return performance(num, den, gamma, tmax, signalType::output, outTerms);
+	if (MaxRootRealPart(den) > -1e-6) return 1e20;
+	return stepPerformanceJoint(num, ctrlNum, den, tmax, ctrlType, ctrlWt, outTerms) + gamma*H2sq(num,den);
+}
+
+// Same J over Jets, see Performance.h. Stability from values, as in performance(); unstable den gives J = 1e20 with zero derivatives.
+
+bool performanceJet(const std::vector<Jet>& num, const std::vector<Jet>& ctrlNum, const std::vector<Jet>& den,
+					double gamma, double tmax, signalType ctrlType, double ctrlWt, unsigned long outTerms, Jet& J)
+{
+	std::vector<double> d(den.size());
+	for (size_t i = 0; i < den.size(); ++i) d[i] = den[i].v;
+	if (MaxRootRealPart(d) > -1e-6){
+		J = 1e20;
+		return true;
+	}
+	auto dim = den.size()-1;
+	Jet ycoeff[2][maxStepDim];
+	unsigned long ydim[2];
+	Jet yinputCoeff[2];
+	Jet cost[2];
+	stepCoeff(num, den, signalType::output, ycoeff[0], ydim[0], yinputCoeff[0], outTerms);
+	bool native;
+	if (ctrlWt == 0.0)
+		native = stepNative<1>(dim, den, tmax, ycoeff, yinputCoeff, cost);
+	else {
+		stepCoeff(ctrlNum, den, ctrlType, ycoeff[1], ydim[1], yinputCoeff[1], outTerms);
+		native = stepNative<2>(dim, den, tmax, ycoeff, yinputCoeff, cost);
+	}
+	// output coefficients of all of num, impulse removed from equal sized num and den as in H2sq
+	Jet c[maxStepDim], cInput, h2;
+	unsigned long cdim;
+	stepCoeff(num, den, (num.size() == den.size()) ? signalType::controlOpen : signalType::output, c, cdim, cInput,
+			  num.size());
+	if (!native || !H2sqLyapunov(dim, c, den, h2)) return false;
+	if (cost[0].v >= 1e20 || (ctrlWt != 0.0 && cost[1].v >= 1e20))
+		J = 1e20;
+	else
+		J = (ctrlWt == 0.0) ? cost[0] + gamma*h2 : cost[0] + ctrlWt*cost[1] + gamma*h2;
+	return true;
 }
 
 // coeff of polynomial from low order to high order terms
@@ -121,13 +214,33 @@ double H2sq(const std::vector<double>& num, const std::vector<double>& den)
 	double result, error;
 	gsl_integration_workspace *w = gsl_integration_workspace_alloc (1000);
 	// std::cout << "h2 int start" << std::endl;
-	if (GSL_SUCCESS != gsl_integration_qagi(&F, 0, 1e-7, 1000, w, &result, &error))
+	if (GSL_SUCCESS != gsl_integration_qagi(&F, 0, fidelity.h2Tol, 1000, w, &result, &error))
 		result = 1e30;
 	// std::cout << "h2 int end" << std::endl;
 	gsl_integration_workspace_free(w);
 	return result / (2.0*M_PI);
 }
 
+// H2 squared from observability Gramian Q of companion form in deriv: A'Q + QA = -cc' for output coefficients c, so H2^2 = b'Qb = Q[N-1][N-1] for input b = e_N. Same value as H2sq to its quadrature tolerance, but differentiable, so used for Jets. Compiled for dimensions 2..maxNativeDim, false for others or if singular.
+
+template <class T, int N>
+bool H2sqLyapunov(unsigned long dim, const T c[], const std::vector<T>& den, T& result)
+{
+	if (dim == N){
+		std::array<std::array<T,N>,N> A{};
+		std::array<std::array<T,N>,N> Q;
+		for (int i = 0; i < N-1; ++i) A[i][i+1] = 1.0;
+		for (int i = 0; i < N; ++i) A[N-1][i] = -den[i]/den.back();
+		if (!lyapunovP<N>(A, Q, c)) return false;
+		result = Q[N-1][N-1];
+		return true;
+	}
+	if constexpr (N < maxNativeDim)
+		return H2sqLyapunov<T,N+1>(dim, c, den, result);
+	else
+		return false;
+}
+
 double integrandH2(double w, void *p)
 {
 	gsl_complex s;
@@ -167,32 +280,26 @@ int deriv(double t, const double x[], double f[], void *p)
 // for control signals, diff coeff for open and closed loops
 // see MMA file
 
-double stepPerformance(const std::vector<double>& num, const std::vector<double>& den, double tmax, signalType s)
+template <class T>
+void stepCoeff(const std::vector<T>& num, const std::vector<T>& den, signalType s,
+			   T ycoeff[maxStepDim], unsigned long& ydim, T& yinputCoeff, unsigned long outTerms)
 {
-	double time[steps+1];
-	double y[steps+1];
-	my_params params = {num, den};
 	auto dim = den.size()-1;	// dimensions of state space model for dynamics
-	gsl_odeiv2_system sys = {deriv, NULL, dim, &params};
-    // see GSL docs for alternative algorithms
-	gsl_odeiv2_driver *d =
-		gsl_odeiv2_driver_alloc_y_new (&sys, gsl_odeiv2_step_rkf45, 1e-6, 1e-6, 0.0);
-	double t = 0.0;
-	double denBack = den.back();
+	T denBack = den.back();
 	
-	// coefficients to get output, initialize with values for each case, max dim is 4, so use that
-	double ycoeff[4];
-	unsigned long ydim;		// number of output coefficients to get output y, varies by problem, set explicitly
-	double yinputCoeff = 0;	// must add yinputCoeff * input to output; input=1 for the step response 
+	// coefficients to get output, initialize with values for each case, max dim is maxStepDim, so use that
+	for (unsigned i = 0; i < maxStepDim; ++i) ycoeff[i] = 0.0;
+	yinputCoeff = 0;	// must add yinputCoeff * input to output; input=1 for the step response 
 	
 	if (s == signalType::output){ // case of output signal, same for open and closed loops
-		ydim = 3; 
-		ycoeff[0] = num[0]/denBack; ycoeff[1] = num[1]/denBack; ycoeff[2] = num[2]/denBack;
+		ydim = std::min(outTerms, num.size());
+		for (unsigned i = 0; i < ydim; ++i)
+			ycoeff[i] = num[i]/denBack;
 	}
 	else {
 		// cases of control signal, # coeff is always dimension of problem, dim
 		ydim = dim;
-		double numBack = num.back();
+		T numBack = num.back();
 		yinputCoeff = numBack / denBack;
 		if (s == signalType::controlOpen) { // control signal, open loop
 			for (unsigned i = 0; i < ydim; ++i)
@@ -201,15 +308,15 @@ double stepPerformance(const std::vector<double>& num, const std::vector<double>
 		else if (s == signalType::controlClosed) { // control signal, closed loop
 			for (unsigned i = 0; i < ydim; ++i){
 				ycoeff[i] = (num[i] - den[i]*yinputCoeff) / denBack;
-				if (debugPerformance >= 2) std::cout << ycoeff[i] << " ";
+				if (debugPerformance >= 2) std::cout << Value(ycoeff[i]) << " ";
 			}
-			if (debugPerformance >= 2) std::cout << yinputCoeff << std::endl;
+			if (debugPerformance >= 2) std::cout << Value(yinputCoeff) << std::endl;
 			if (debugPerformance >= 2){
-				for (auto& n : den) std::cout << -n/denBack << " ";
+				for (auto& n : den) std::cout << -Value(n)/Value(denBack) << " ";
 				std::cout << std::endl;
-				for (auto& n : num) std::cout << n << " ";
+				for (auto& n : num) std::cout << Value(n) << " ";
 				std::cout << std::endl;
-				for (auto& n : den) std::cout << n << " ";
+				for (auto& n : den) std::cout << Value(n) << " ";
 				std::cout << std::endl;
 			}
 		}
@@ -217,6 +324,112 @@ double stepPerformance(const std::vector<double>& num, const std::vector<double>
 			assert(false);	// should not be here, signal must be one of above types
 		}
 	}
+}
+
+double stepPerformance(const std::vector<double>& num, const std::vector<double>& den, double tmax, signalType s,
+					   unsigned long outTerms)
+{
+	auto dim = den.size()-1;	// dimensions of state space model for dynamics
+	double ycoeff[1][maxStepDim];
+	unsigned long ydim;		// number of output coefficients to get output y, varies by problem, set explicitly
+	double yinputCoeff[1];
+	stepCoeff(num, den, s, ycoeff[0], ydim, yinputCoeff[0], outTerms);
+
+	double result;
+	if (method == stepMethod::gsl || !stepNative<1>(dim, den, tmax, ycoeff, yinputCoeff, &result))
+		return stepPerformanceGSL(num, den, tmax, s, ycoeff[0], ydim, yinputCoeff[0]);
+	if (method == stepMethod::parity || debugPerformance)
+		result = checkParity(result, stepPerformanceGSL(num, den, tmax, s, ycoeff[0], ydim, yinputCoeff[0]));
+	return result;
+}
+
+// Samples of output and control signal for stepResponse, see Performance.h; settling check fills later samples with steady state
+
+bool stepResponse(const std::vector<double>& num, const std::vector<double>& ctrlNum, const std::vector<double>& den,
+				  signalType ctrlType, const std::vector<double>& t, std::vector<double>& y, unsigned long outTerms)
+{
+	auto dim = den.size()-1;
+	double ycoeff[2][maxStepDim];
+	unsigned long ydim[2];
+	double yinputCoeff[2];
+	stepCoeff(num, den, signalType::output, ycoeff[0], ydim[0], yinputCoeff[0], outTerms);
+	stepCoeff(ctrlNum, den, ctrlType, ycoeff[1], ydim[1], yinputCoeff[1], outTerms);
+	auto n = static_cast<int>(t.size());
+	y.assign(2*t.size(), 0.0);
+	double cost[2];
+	if (!stepNative<2>(dim, den, t.back(), ycoeff, yinputCoeff, cost, n, t.data(), y.data()))
+		return false;
+	return cost[0] < 1e20;
+}
+
+// Output and control signal share state x, so native integration carries both squared errors as extra states of one pass and returns output cost + ctrlWt * control cost. GSL path integrates each signal separately.
+
+double stepPerformanceJoint(const std::vector<double>& num, const std::vector<double>& ctrlNum,
+							const std::vector<double>& den, double tmax, signalType ctrlType, double ctrlWt,
+							unsigned long outTerms)
+{
+	auto dim = den.size()-1;
+	double ycoeff[2][maxStepDim];
+	unsigned long ydim[2];
+	double yinputCoeff[2];
+	stepCoeff(num, den, signalType::output, ycoeff[0], ydim[0], yinputCoeff[0], outTerms);
+	stepCoeff(ctrlNum, den, ctrlType, ycoeff[1], ydim[1], yinputCoeff[1], outTerms);
+	auto gslCost = [&](){
+		return stepPerformanceGSL(num, den, tmax, signalType::output, ycoeff[0], ydim[0], yinputCoeff[0])
+			+ ctrlWt*stepPerformanceGSL(ctrlNum, den, tmax, ctrlType, ycoeff[1], ydim[1], yinputCoeff[1]);
+	};
+
+	double cost[2];
+	if (method == stepMethod::gsl || !stepNative<2>(dim, den, tmax, ycoeff, yinputCoeff, cost))
+		return gslCost();
+	double result = (cost[0] >= 1e20 || cost[1] >= 1e20) ? 1e20 : cost[0] + ctrlWt*cost[1];
+	if (method == stepMethod::parity || debugPerformance)
+		result = checkParity(result, gslCost());
+	return result;
+}
+
+// Native integration compiled for each dimension 2..maxNativeDim, so state arrays and loops have fixed size; false for other dimensions, which go to GSL
+
+template <int K, int N, class T>
+bool stepNative(unsigned long dim, const std::vector<T>& den, double tmax, const T ycoeff[][maxStepDim],
+				const T yinputCoeff[], T cost[], int nSample, const double *sampleT, double *sampleY)
+{
+	if (dim == N){
+		stepPerformanceNative<N,K>(den, tmax, ycoeff, yinputCoeff, cost, nSample, sampleT, sampleY);
+		return true;
+	}
+	if constexpr (N < maxNativeDim)
+		return stepNative<K,N+1>(dim, den, tmax, ycoeff, yinputCoeff, cost, nSample, sampleT, sampleY);
+	else
+		return false;
+}
+
+// record difference between native result and GSL result g, return value selected by method
+
+double checkParity(double result, double g)
+{
+	double diff = std::abs(result - g);
+	parity.count++;
+	parity.maxAbs = std::max(parity.maxAbs, diff);
+	parity.maxRel = std::max(parity.maxRel, diff/std::max(std::abs(g), 1e-12));
+	if (debugPerformance)
+		std::cout << fmt::format("step native = {}, gsl = {}, diff = {:.3e}\n", result, g, diff);
+	return (method == stepMethod::parity) ? g : result;
+}
+
+double stepPerformanceGSL(const std::vector<double>& num, const std::vector<double>& den, double tmax,
+					signalType s, const double ycoeff[], unsigned long ydim, double yinputCoeff)
+{
+	int steps = fidelity.steps;
+	std::vector<double> time(steps+1);
+	std::vector<double> y(steps+1);
+	my_params params = {num, den};
+	auto dim = den.size()-1;	// dimensions of state space model for dynamics
+	gsl_odeiv2_system sys = {deriv, NULL, dim, &params};
+    // see GSL docs for alternative algorithms
+	gsl_odeiv2_driver *d =
+		gsl_odeiv2_driver_alloc_y_new (&sys, gsl_odeiv2_step_rkf45, fidelity.odeTol, fidelity.odeTol, 0.0);
+	double t = 0.0;
 
 	time[0] = 0.0;
 	// at time zero with step, dominated by infinite freq, so if order of den > num, then at time zero,
@@ -243,7 +456,7 @@ double stepPerformance(const std::vector<double>& num, const std::vector<double>
 	
 	gsl_interp_accel *acc = gsl_interp_accel_alloc();
     gsl_spline *spline = gsl_spline_alloc(gsl_interp_cspline, steps);
-    if (GSL_SUCCESS != gsl_spline_init (spline, time, y, steps)){
+    if (GSL_SUCCESS != gsl_spline_init (spline, time.data(), y.data(), steps)){
     	gsl_spline_free (spline);
     	gsl_interp_accel_free (acc);
     	return 1e20;
@@ -258,9 +471,9 @@ double stepPerformance(const std::vector<double>& num, const std::vector<double>
 	double result, error;
 	gsl_integration_workspace *w = gsl_integration_workspace_alloc (1000);
 	// std::cout << "step int start" << std::endl;
-	// using 1e-6 for abs and rel error
-	double errtol = 1e-6;
-	if (GSL_SUCCESS != gsl_integration_qag(&F, 0.0, tmax, errtol, errtol, 1000, 6, w, &result, &error)){
+	// using same abs and rel error, 1e-6 at full fidelity
+	double errtol = fidelity.stepTol;
+	if (GSL_SUCCESS != gsl_integration_qag(&F, 0.0, tmax, errtol, errtol, 1000, fidelity.qagKey, w, &result, &error)){
 		gsl_integration_cquad_workspace *ctable = gsl_integration_cquad_workspace_alloc(200);
 		if (GSL_SUCCESS != gsl_integration_cquad(&F, 0, tmax, errtol, errtol, ctable, &result, &error, NULL)){
      		boost::math::tools::polynomial<double> poly_newnum(num.begin(), num.end());
@@ -290,3 +503,200 @@ double integrandStep(double t, void *p)
 	return z*z;
 }
 
+// Native integration of step response, N is dimension of state space model, see stepNative. State is x[0..N-1] of companion form system in deriv plus x[N+k], the integral of (1-y_k)^2 for each of K signals y_k = ycoeff[k].x + yinputCoeff[k], so cost[k] is x[N+k] at tmax and no spline or quadrature needed. K = 2 for output and control signal together.
+
+// Dormand-Prince 5(4) embedded pair with first same as last stage, error control on absolute error fidelity.odeTol for all components as in GSL driver above.
+
+// With nSample > 0, y_k at times sampleT, ascending in [0,tmax], go to sampleY[k*nSample + j]; steps end at each sample time, so sampled values carry the same error control as the cost.
+
+// Settling: let z be deviation of state from steady state. Because dz/dt = Az with A stable, for P solving A'P + PA = -I, V = z'Pz satisfies dV/dt = -|z|^2, so integral of |z|^2 from t to infinity is V(t). With e the steady state error of the output and c the output coefficients, by Cauchy-Schwarz the remaining integral of (1-y)^2 = (e - c.z)^2 over [t,tmax] differs from e^2 (tmax-t) by at most |c|^2 V + 2|e||c| sqrt((tmax-t) V). Once that bound is below settleTol for every signal, add e^2 (tmax-t) to each and stop.
+
+template <int N, int K, class T>
+void stepPerformanceNative(const std::vector<T>& den, double tmax, const T ycoeff[][maxStepDim],
+						   const T yinputCoeff[], T cost[],
+						   int nSample, const double *sampleT, double *sampleY)
+{
+	using State = std::array<T,N+K>;
+	const double tol = fidelity.odeTol;
+	const double settleTol = 0.01*tol;
+	const double hmin = 1e-12;
+	// Dormand-Prince coefficients
+	const double a21 = 1.0/5.0;
+	const double a31 = 3.0/40.0, a32 = 9.0/40.0;
+	const double a41 = 44.0/45.0, a42 = -56.0/15.0, a43 = 32.0/9.0;
+	const double a51 = 19372.0/6561.0, a52 = -25360.0/2187.0, a53 = 64448.0/6561.0, a54 = -212.0/729.0;
+	const double a61 = 9017.0/3168.0, a62 = -355.0/33.0, a63 = 46732.0/5247.0, a64 = 49.0/176.0,
+		a65 = -5103.0/18656.0;
+	const double b1 = 35.0/384.0, b3 = 500.0/1113.0, b4 = 125.0/192.0, b5 = -2187.0/6784.0, b6 = 11.0/84.0;
+	const double e1 = 71.0/57600.0, e3 = -71.0/16695.0, e4 = 71.0/1920.0, e5 = -17253.0/339200.0,
+		e6 = 22.0/525.0, e7 = -1.0/40.0;
+
+	// last row of companion matrix and output coefficients
+	T denBack = den.back();
+	T arow[N];
+	for (int i = 0; i < N; ++i)
+		arow[i] = -den[i]/denBack;
+	auto f = [&](const State& x, State& dx){
+		T last = 1.0;
+		for (int i = 0; i < N-1; ++i){
+			dx[i] = x[i+1];
+			last += arow[i]*x[i];
+		}
+		dx[N-1] = last + arow[N-1]*x[N-1];
+		for (int k = 0; k < K; ++k){
+			T y = yinputCoeff[k];
+			for (int i = 0; i < N; ++i) y += ycoeff[k][i]*x[i];
+			dx[N+k] = (1.0 - y)*(1.0 - y);
+		}
+	};
+
+	// steady state and Lyapunov matrix for settling test, if P fails, never settle; the test needs values only
+	std::array<std::array<double,N>,N> A{};
+	std::array<std::array<double,N>,N> P;
+	for (int i = 0; i < N-1; ++i) A[i][i+1] = 1.0;
+	for (int i = 0; i < N; ++i) A[N-1][i] = Value(arow[i]);
+	bool canSettle = lyapunovP<N>(A, P) && std::abs(Value(den[0])) > 0.0;
+	T xss0 = (canSettle) ? denBack/den[0] : 0.0;
+	T ess[K];
+	double cnorm[K];
+	for (int k = 0; k < K; ++k){
+		ess[k] = 1.0 - yinputCoeff[k] - ycoeff[k][0]*xss0;
+		cnorm[k] = 0.0;
+		for (int i = 0; i < N; ++i) cnorm[k] += Value(ycoeff[k][i])*Value(ycoeff[k][i]);
+		cnorm[k] = sqrt(cnorm[k]);
+	}
+	auto fail = [&](){
+		for (int k = 0; k < K; ++k) cost[k] = 1e20;
+		stepFailures.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	State x{}, k1, k2, k3, k4, k5, k6, k7, xt, x5;
+	double t = 0.0;
+	double h = 1e-3;
+	int next = 0;			// next sample
+	auto sample = [&](){
+		for (; next < nSample && sampleT[next] <= t; ++next){
+			for (int k = 0; k < K; ++k){
+				T y = yinputCoeff[k];
+				for (int i = 0; i < N; ++i) y += ycoeff[k][i]*x[i];
+				sampleY[k*nSample + next] = Value(y);
+			}
+		}
+	};
+	sample();
+	f(x, k1);
+	while (t < tmax){
+		if (t + h > tmax) h = tmax - t;
+		bool toSample = (next < nSample && t + h >= sampleT[next]);
+		if (toSample) h = sampleT[next] - t;
+		for (int i = 0; i < N+K; ++i) xt[i] = x[i] + h*a21*k1[i];
+		f(xt, k2);
+		for (int i = 0; i < N+K; ++i) xt[i] = x[i] + h*(a31*k1[i] + a32*k2[i]);
+		f(xt, k3);
+		for (int i = 0; i < N+K; ++i) xt[i] = x[i] + h*(a41*k1[i] + a42*k2[i] + a43*k3[i]);
+		f(xt, k4);
+		for (int i = 0; i < N+K; ++i) xt[i] = x[i] + h*(a51*k1[i] + a52*k2[i] + a53*k3[i] + a54*k4[i]);
+		f(xt, k5);
+		for (int i = 0; i < N+K; ++i)
+			xt[i] = x[i] + h*(a61*k1[i] + a62*k2[i] + a63*k3[i] + a64*k4[i] + a65*k5[i]);
+		f(xt, k6);
+		for (int i = 0; i < N+K; ++i)
+			x5[i] = x[i] + h*(b1*k1[i] + b3*k3[i] + b4*k4[i] + b5*k5[i] + b6*k6[i]);
+		f(x5, k7);
+		double err = 0.0;
+		for (int i = 0; i < N+K; ++i){
+			double ei = h*(e1*Value(k1[i]) + e3*Value(k3[i]) + e4*Value(k4[i]) + e5*Value(k5[i]) + e6*Value(k6[i])
+						   + e7*Value(k7[i]));
+			err = std::max(err, std::abs(ei)/tol);
+		}
+		if (!std::isfinite(err)){
+			fail();
+			return;
+		}
+		if (err <= 1.0){
+			t = (toSample) ? sampleT[next] : t + h;	// exact, so sample() takes it
+			x = x5;
+			k1 = k7;
+			sample();
+			h *= (err > 0.0) ? std::min(5.0, 0.9*pow(err, -0.2)) : 5.0;
+			if (canSettle && t < tmax){
+				double z[N];
+				for (int i = 0; i < N; ++i) z[i] = Value(x[i]);
+				z[0] -= Value(xss0);
+				double V = 0.0;
+				for (int i = 0; i < N; ++i)
+					for (int j = 0; j < N; ++j)
+						V += z[i]*P[i][j]*z[j];
+				bool settled = true;
+				for (int k = 0; k < K; ++k)
+					settled = settled && (cnorm[k]*cnorm[k]*V + 2.0*std::abs(Value(ess[k]))*cnorm[k]*sqrt((tmax - t)*V)
+										  < settleTol);
+				if (settled){
+					for (int k = 0; k < K; ++k) x[N+k] += ess[k]*ess[k]*(tmax - t);
+					for (; next < nSample; ++next)
+						for (int k = 0; k < K; ++k) sampleY[k*nSample + next] = 1.0 - Value(ess[k]);
+					break;
+				}
+			}
+		}
+		else
+			h *= std::max(0.2, 0.9*pow(err, -0.25));
+		if (h < hmin){
+			// not on stdout, which carries results of evalBatch
+			if (debugPerformance) std::cerr << fmt::format("Native step integration failed at t = {}\n", t);
+			fail();
+			return;
+		}
+	}
+	for (int k = 0; k < K; ++k) cost[k] = x[N+k];
+}
+
+// Solve A'P + PA = -I, or -cc' if c given, for symmetric P by Gaussian elimination on the N(N+1)/2 unknowns P[i][j], i <= j. Returns false if singular, which happens only if A has eigenvalues summing to zero.
+
+template <int N, class T>
+bool lyapunovP(const std::array<std::array<T,N>,N>& A, std::array<std::array<T,N>,N>& P, const T *c)
+{
+	constexpr int M = N*(N+1)/2;
+	int idx[N][N];
+	int k = 0;
+	for (int i = 0; i < N; ++i)
+		for (int j = i; j < N; ++j)
+			idx[i][j] = idx[j][i] = k++;
+	T E[M][M+1] = {};
+	for (int i = 0; i < N; ++i){
+		for (int j = i; j < N; ++j){
+			int r = idx[i][j];
+			for (int m = 0; m < N; ++m){
+				E[r][idx[m][j]] += A[m][i];		// (A'P)[i][j]
+				E[r][idx[i][m]] += A[m][j];		// (PA)[i][j]
+			}
+			if (c)
+				E[r][M] = -(c[i]*c[j]);
+			else
+				E[r][M] = (i == j) ? -1.0 : 0.0;
+		}
+	}
+	for (int col = 0; col < M; ++col){
+		int piv = col;
+		for (int r = col+1; r < M; ++r)
+			if (std::abs(Value(E[r][col])) > std::abs(Value(E[piv][col]))) piv = r;
+		if (std::abs(Value(E[piv][col])) < 1e-14) return false;
+		if (piv != col)
+			for (int m = col; m <= M; ++m) std::swap(E[col][m], E[piv][m]);
+		for (int r = col+1; r < M; ++r){
+			T fct = E[r][col]/E[col][col];
+			for (int m = col; m <= M; ++m) E[r][m] -= fct*E[col][m];
+		}
+	}
+	T sol[M];
+	for (int r = M-1; r >= 0; --r){
+		T sum = E[r][M];
+		for (int m = r+1; m < M; ++m) sum -= E[r][m]*sol[m];
+		sol[r] = sum/E[r][r];
+	}
+	for (int i = 0; i < N; ++i)
+		for (int j = 0; j < N; ++j)
+			P[i][j] = sol[idx[i][j]];
+	return true;
+}
+
@@ -4,6 +4,8 @@
 
 #include <gsl/gsl_errno.h>
 
+#include "Jet.h"
+
 // if p0 is less than chop, then set to zero, associated with calling routine chop
 const double chop = 1e-3;
 const double p1bound = 1e-5;
@@ -12,8 +14,40 @@ void debugPerformanceOn(unsigned);
 
 enum class signalType {output, controlOpen, controlClosed};
 
+// Step response integration: native => embedded Runge-Kutta specialized at compile time for each dimension 2..maxNativeDim, accumulating squared error as extra state and stopping once response has settled, other dimensions use GSL; gsl => GSL driver, spline and quadrature; parity => both, return GSL value and track differences
+enum class stepMethod {native, gsl, parity};
+struct StepParity {unsigned long count; double maxAbs; double maxRel;};
+
+// Numerical fidelity: interpolation steps for GSL step response, ODE tolerance, qag Gauss-Kronrod key and tolerance for step response quadrature, qagi relative tolerance for H2. Full fidelity is the original fixed accuracy; scaledFidelity(s) multiplies tolerances by s, for ranking individuals early in long runs, see LifeCycle.
+struct Fidelity {int steps; double odeTol; int qagKey; double stepTol; double h2Tol;};
+const Fidelity fullFidelity = {5000, 1e-6, 6, 1e-6, 1e-7};
+Fidelity scaledFidelity(double scale);
+void setFidelity(const Fidelity& f);
+Fidelity getFidelity();
+
+void setStepMethod(stepMethod m);       // also resets parity statistics
+stepMethod getStepMethod();
+StepParity getStepParity();
+unsigned long getStepFailures();        // native integrations that failed, J = 1e20, since setStepMethod; thread safe
+
+// State dimension of step response is den.size() - 1: native integration compiled for 2..maxNativeDim, GSL for other dimensions up to maxStepDim
+const int maxNativeDim = 8;
+const int maxStepDim = 16;
+
+// Output y uses the first outTerms coefficients of num. Original model uses 3, which for dclose leaves out the s^3 term of num; kept so results do not change. Generic orders, see EvalTransfer, pass num.size().
 double performance(const std::vector<double>& num, const std::vector<double>& den, 
-					double gamma, double tmax, signalType s);
+					double gamma, double tmax, signalType s, unsigned long outTerms = 3);
+// Output cost + ctrlWt * control signal cost + gamma * H2, ctrlNum is numerator of control signal transfer function over den, same size as den; native integration gets both costs from one pass
+double performance(const std::vector<double>& num, const std::vector<double>& ctrlNum, const std::vector<double>& den,
+					double gamma, double tmax, signalType ctrlType, double ctrlWt, unsigned long outTerms = 3);
+// J of performance() above over Jet coefficients, for derivatives with respect to whatever variables the Jets carry. Native integration only, so den of dimension 2..maxNativeDim, else false; H2 from a Lyapunov equation rather than quadrature, so J agrees with performance() to the tolerances of both.
+bool performanceJet(const std::vector<Jet>& num, const std::vector<Jet>& ctrlNum, const std::vector<Jet>& den,
+					double gamma, double tmax, signalType ctrlType, double ctrlWt, unsigned long outTerms, Jet& J);
+// Step response of output and control signal at times t, ascending, from 0; y[j] is output, y[n + j] control signal at t[j], n = t.size(). One native integration, den of dimension 2..maxNativeDim only, else false; false also if integration fails.
+bool stepResponse(const std::vector<double>& num, const std::vector<double>& ctrlNum, const std::vector<double>& den,
+				  signalType ctrlType, const std::vector<double>& t, std::vector<double>& y, unsigned long outTerms = 3);
+// max real part of roots of polynomial, > -1e-6 is unstable in performance(); root signs do not depend on coefficient order
+double MaxRootRealPart(const std::vector<double>& coeff);
 
 // GSL error handling: call setGSLErrorHandle(s), s = 0 turns off error handler, 1 sets my handler; should check return status of all significant GSL calls and take appropriate action within code, for example return high performance value and thus zero fitness if cannot evaluate performance for parameter combination
 inline void my_gsl_handler (const char *reason, const char *file, int line, int gsl_errno __attribute__((unused)))
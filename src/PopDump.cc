@@ -0,0 +1,162 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <iostream>
+#include <algorithm>
+
+#include "PopDump.h"
+#include "Numa.h"
+#include APPL_H
+
+const size_t dumpAlign = 4096;
+
+PopDumpWriter::PopDumpWriter(size_t m) : maxQueue(m)
+{
+    writer = std::thread(&PopDumpWriter::run, this);
+}
+
+PopDumpWriter::~PopDumpWriter()
+{
+    // destructor may run during exception unwinding or at exit, so report writer errors but do not rethrow
+    try {close();}
+    catch (std::exception& e) {std::cerr << e.what() << std::endl;}
+    catch (...) {}
+}
+
+void PopDumpWriter::push(std::string filename, DumpHeader header, PopColumns columns)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    notFull.wait(lock, [this]{return queue.size() < maxQueue || error;});
+    if (error) rethrow();
+    queue.push_back({std::move(filename), header, std::move(columns)});
+    notEmpty.notify_one();
+}
+
+void PopDumpWriter::close()
+{
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+    }
+    notEmpty.notify_one();
+    writer.join();
+    std::lock_guard<std::mutex> lock(mtx);
+    if (error) rethrow();
+}
+
+void PopDumpWriter::rethrow()
+{
+    auto e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+}
+
+void PopDumpWriter::run()
+{
+    NumaWidenThread();      // thread inherits the pin of the compute thread, see Numa.h
+    while (true){
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            notEmpty.wait(lock, [this]{return !queue.empty() || done;});
+            if (queue.empty()) return;
+            item = std::move(queue.front());
+            queue.pop_front();
+        }
+        notFull.notify_one();
+        try {
+            write(item);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            error = std::current_exception();
+            queue.clear();
+            notFull.notify_one();
+            return;
+        }
+    }
+}
+
+// pwrite all of buf at offset, bytes swapped to little endian if host is big endian
+
+void PwriteLE(int fd, const char *buf, size_t n, size_t at, size_t word, const std::string& name)
+{
+    const uint16_t probe = 1;
+    std::vector<char> swapped;
+    if (word > 1 && *reinterpret_cast<const char *>(&probe) == 0){
+        swapped.assign(buf, buf + n);
+        for (size_t i = 0; i + word <= n; i += word) std::reverse(&swapped[i], &swapped[i] + word);
+        buf = swapped.data();
+    }
+    while (n > 0){
+        auto w = pwrite(fd, buf, n, static_cast<off_t>(at));
+        if (w < 0){
+            if (errno == EINTR) continue;
+            ThrowError(__FILE__, __LINE__, "Write of " + name + " failed: " + strerror(errno));
+        }
+        buf += w;
+        at += static_cast<size_t>(w);
+        n -= static_cast<size_t>(w);
+    }
+}
+
+void PopDumpWriter::write(const Item& item)
+{
+    DumpHeader h = item.header;
+    const auto& cols = item.columns.cols;
+    memcpy(h.magic, "senspop1", sizeof(h.magic));
+    h.version = 1;
+    h.cols = static_cast<uint32_t>(cols.size());
+    h.rows = (cols.empty()) ? 0 : cols[0].size();
+    size_t tableEnd = sizeof(DumpHeader) + cols.size()*sizeof(DumpColumn);
+    h.dataOffset = (tableEnd + dumpAlign - 1)/dumpAlign*dumpAlign;
+    auto colBytes = static_cast<size_t>(h.rows)*sizeof(double);
+
+    std::string tmp = item.filename + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        ThrowError(__FILE__, __LINE__, "Could not open " + tmp + ": " + strerror(errno));
+    try {
+        // header fields one at a time, so each is swapped by its own size
+        std::vector<char> head(static_cast<size_t>(h.dataOffset), 0);
+        PwriteLE(fd, head.data(), head.size(), 0, 1, tmp);
+        PwriteLE(fd, h.magic, sizeof(h.magic), offsetof(DumpHeader, magic), 1, tmp);
+        auto field = [&](const auto& x, size_t at){
+            PwriteLE(fd, reinterpret_cast<const char *>(&x), sizeof(x), at, sizeof(x), tmp);
+        };
+        field(h.version, offsetof(DumpHeader, version));
+        field(h.cols, offsetof(DumpHeader, cols));
+        field(h.rows, offsetof(DumpHeader, rows));
+        field(h.dataOffset, offsetof(DumpHeader, dataOffset));
+        field(h.runNum, offsetof(DumpHeader, runNum));
+        field(h.loci, offsetof(DumpHeader, loci));
+        field(h.gen, offsetof(DumpHeader, gen));
+        field(h.stoch, offsetof(DumpHeader, stoch));
+        field(h.rndSeed, offsetof(DumpHeader, rndSeed));
+        for (size_t c = 0; c < cols.size(); ++c){
+            if (cols[c].size() != h.rows)
+                ThrowError(__FILE__, __LINE__, "Columns of population dump differ in length");
+            DumpColumn d{};
+            strncpy(d.name, item.columns.names[c].c_str(), sizeof(d.name) - 1);
+            d.offset = h.dataOffset + c*colBytes;
+            size_t at = sizeof(DumpHeader) + c*sizeof(DumpColumn);
+            PwriteLE(fd, d.name, sizeof(d.name), at + offsetof(DumpColumn, name), 1, tmp);
+            field(d.offset, at + offsetof(DumpColumn, offset));
+            PwriteLE(fd, reinterpret_cast<const char *>(cols[c].data()), colBytes, static_cast<size_t>(d.offset),
+                     sizeof(double), tmp);
+        }
+    }
+    catch (...) {
+        ::close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+    if (::close(fd) != 0 || rename(tmp.c_str(), item.filename.c_str()) != 0){
+        unlink(tmp.c_str());
+        ThrowError(__FILE__, __LINE__, "Could not complete " + item.filename + ": " + strerror(errno));
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef _PopDump_h
+#define _PopDump_h 1
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+
+// Raw dump of final population, param dump > 0, one file per run, output/pop.<tag.>Run<n>.bin; replicates of one runNum in adaptive sampling, -a, add .rep<k> for k = 1, 2, ... Columns are those calcStats builds for its statistics, g0.. then s0.. if stochWt, fitness and J, one value per individual in population order, so a row is an individual; fitness is that used for selection, J is the fresh evaluation of calcStats, each with its own noise draws.
+
+// File layout, all little endian: DumpHeader, then cols DumpColumn entries, then zero padding to dataOffset, a multiple of 4096, then the columns, each rows float64 values, contiguous and in table order. Column c starts at its offset, dataOffset + 8 c rows, so a reader maps the file and views each column in place, for example in numpy np.memmap(name, dtype='<f8', mode='r', offset=offset, shape=(rows,)). Files are written under a temporary name and renamed, so a file that exists is complete.
+
+// calcStats moves its column vectors into PopColumns, and the writer thread writes them straight from those vectors and frees them, so the run does not wait for the disk; only percentiles of calcStats work on copies, to keep columns in population order. Queue is bounded, push blocks only when the writer is maxQueue populations behind; errors on the writer thread are rethrown at the next push or at close, as for ResultWriter; main calls close through CloseDumps after the last run.
+
+struct PopColumns {
+    std::vector<std::string>            names;
+    std::vector<std::vector<double>>    cols;       // each of size rows
+};
+
+struct DumpHeader {
+    char        magic[8];       // "senspop1"
+    uint32_t    version;        // 1
+    uint32_t    cols;
+    uint64_t    rows;
+    uint64_t    dataOffset;     // first byte of first column
+    int32_t     runNum;
+    int32_t     loci;
+    int32_t     gen;            // generations run, less than gen param if run stopped early
+    int32_t     stoch;          // 1 => s columns present
+    uint64_t    rndSeed;
+};
+
+struct DumpColumn {
+    char        name[24];       // nul padded
+    uint64_t    offset;         // from start of file
+};
+
+class PopDumpWriter
+{
+public:
+    explicit PopDumpWriter(size_t maxQueue = 2);
+    ~PopDumpWriter();
+    void        push(std::string filename, DumpHeader header, PopColumns columns);
+    void        close();
+private:
+    struct Item {std::string filename; DumpHeader header; PopColumns columns;};
+    void        run();
+    void        write(const Item& item);
+    void        rethrow();
+    size_t      maxQueue;
+    bool        done = false;
+    std::deque<Item>        queue;
+    std::mutex              mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::exception_ptr      error;
+    std::thread             writer;
+};
+
+#endif
@@ -3,11 +3,12 @@
 #include "Population.h"
 #include "util.h"
 
-Population::Population(Param& param)
+Population::Population(Param& param, bool init)
 {
     static bool flag = true;
     std::string showRec;
     popSize = param.popsize;
+    numLoci = param.loci;
     ind = std::vector<Individual>(popSize);
     indFitness = std::vector<double>(popSize);
     hvec = std::vector<uint64_t>(popSize);
@@ -15,8 +16,12 @@ Population::Population(Param& param)
 
     Individual::setParam(param);            // static function to set static variables
 	for (int i = 0; i < popSize; i++){
-		ind[i].initialize();
-        indFitness[i] = ind[i].getFitness();
+        if (init){
+            ind[i].initialize();
+            indFitness[i] = ind[i].getFitness();
+        }
+        else
+            ind[i].allocate();
 	}
     auto rec = param.recombination;
     double logRec = -log2(rec);
@@ -50,14 +55,105 @@ void Population::setFitnessArray()
     }
 }
 
+// Fitness under current parameters, for individuals taken from a run with different aSD or stochWt
+
+void Population::recalcFitness()
+{
+    for (int i = 0; i < popSize; ++i){
+        indFitness[i] = ind[i].calcFitness();
+    }
+}
+
+// Total variation distance between selection probabilities from fitness at fidelity lo and at fidelity hi. Each individual uses the same random stream, seeded from seed and its index, at both fidelities, so only numerical error differs. Global rnd and stored fitness are not changed.
+
+double Population::fidelityChange(const Fidelity& lo, const Fidelity& hi, unsigned long seed)
+{
+    auto& p = Individual::getEvalParam();
+    bool random = p.stoch || std::abs(p.aSD) > 1e-6;
+    SAFrand_pcg<pcgT> r;
+    std::vector<double> w[2];
+    double sum[2] = {0.0, 0.0};
+    auto saved = getFidelity();
+    for (int f = 0; f < 2; ++f){
+        setFidelity((f == 0) ? lo : hi);
+        w[f].resize(popSize);
+        for (int i = 0; i < popSize; ++i){
+            if (random) r.setRandSeed(static_cast<rndType>(RowSeed(seed, static_cast<size_t>(i))));
+            w[f][i] = EvalFitness(EvalJ(ind[i].getGenotype().get(), ind[i].getStochast().get(), p, r), p);
+            sum[f] += w[f][i];
+        }
+    }
+    setFidelity(saved);
+    if (sum[0] <= 0.0 || sum[1] <= 0.0) return (sum[0] == sum[1]) ? 0.0 : 1.0;
+    double tv = 0.0;
+    for (int i = 0; i < popSize; ++i)
+        tv += std::abs(w[0][i]/sum[0] - w[1][i]/sum[1]);
+    return 0.5*tv;
+}
+
+// Statistics for Equilibrium, see Equilibrium.h. Allele variance from sums of deviations from first individual, which avoids cancellation when alleles are nearly fixed.
+
+GenStats Population::genStats(bool alleles)
+{
+    GenStats s;
+    double n = popSize;
+    double sum = 0.0, ss = 0.0;
+    for (int i = 0; i < popSize; ++i) sum += indFitness[i];
+    s.fitMean = sum/n;
+    for (int i = 0; i < popSize; ++i) ss += (indFitness[i] - s.fitMean)*(indFitness[i] - s.fitMean);
+    s.fitSD = sqrt(ss/n);
+    if (!alleles) return s;
+    auto L = static_cast<size_t>(numLoci);
+    const Allele *g0 = ind[0].getGenotype().get();
+    std::vector<double> d(L, 0.0), dd(L, 0.0);
+    for (int i = 0; i < popSize; ++i){
+        const Allele *g = ind[i].getGenotype().get();
+        for (size_t j = 0; j < L; ++j){
+            double x = g[j] - g0[j];
+            d[j] += x;
+            dd[j] += x*x;
+        }
+    }
+    for (size_t j = 0; j < L; ++j) s.gVar += dd[j]/n - (d[j]/n)*(d[j]/n);
+    s.gVar /= static_cast<double>(L);
+    return s;
+}
+
+// Address and size of each buffer of population, appended to r
+
+void Population::memoryRanges(std::vector<std::pair<const void *, size_t>>& r)
+{
+    auto L = static_cast<size_t>(numLoci);
+    r.push_back({ind.data(), ind.size()*sizeof(Individual)});
+    r.push_back({indFitness.data(), indFitness.size()*sizeof(double)});
+    r.push_back({hvec.data(), hvec.size()*sizeof(uint64_t)});
+    r.push_back({avec.data(), avec.size()*sizeof(uint32_t)});
+    auto G = static_cast<size_t>(Individual::getTotalLoci());
+    for (auto& x : ind){
+        if (x.getGenotype()) r.push_back({x.getGenotype().get(), L*sizeof(Allele)});
+        if (x.getStochast()) r.push_back({x.getStochast().get(), L*sizeof(Allele)});
+        if (x.getAlleles()) r.push_back({x.getAlleles().get(), G*sizeof(Allele)});
+        if (x.getTraitSums()) r.push_back({x.getTraitSums().get(), L*sizeof(double)});
+    }
+}
+
 // Do everything on population in one loop
 
 void Population::reproduceMutateCalcFit(Population& oldPop)
 {
     oldPop.createAliasTable();
     for (int i = 0; i < popSize; ++i){
-        SetBaby(oldPop.chooseInd(), oldPop.chooseInd(), ind[i]);
-        ind[i].mutate();
+        if (genealogy){
+            auto& parent1 = oldPop.chooseInd();
+            auto& parent2 = oldPop.chooseInd();
+            SetBaby(parent1, parent2, ind[i]);
+            ind[i].mutate();
+            recordBirth(parent1, parent2, ind[i]);
+        }
+        else{
+            SetBaby(oldPop.chooseInd(), oldPop.chooseInd(), ind[i]);
+            ind[i].mutate();
+        }
         indFitness[i] = ind[i].getFitness();
     }
 }
@@ -69,15 +165,55 @@ void Population::reproduceNoMutRec(Population& oldPop)
     auto r = ind[0].getRecombination();
     oldPop.createAliasTable();
     for (int i = 0; i < popSize; ++i){
-        SetBaby(oldPop.chooseInd(), oldPop.chooseInd(), ind[i]);
+        if (genealogy){
+            auto& parent1 = oldPop.chooseInd();
+            auto& parent2 = oldPop.chooseInd();
+            SetBaby(parent1, parent2, ind[i]);
+            recordBirth(parent1, parent2, ind[i]);
+        }
+        else
+            SetBaby(oldPop.chooseInd(), oldPop.chooseInd(), ind[i]);
         indFitness[i] = ind[i].getFitness();
     }
     ind[0].setRecombination(r);
 }
 
+// Genealogy: founders are roots, each birth adds node, edges from crossover mask and mutations logged by Individual::mutate
+
+void Population::recordFounders()
+{
+    for (int i = 0; i < popSize; ++i)
+        ind[i].setNode(genealogy->addNode());
+}
+
+void Population::recordBirth(Individual& parent1, Individual& parent2, Individual& baby)
+{
+    int node = genealogy->addNode();
+    baby.setNode(node);
+    if (SetBaby == SetBabyGenotypeNoRec)
+        genealogy->addEdge(parent1.getNode(), node);
+    else
+        genealogy->addEdges(parent1.getNode(), parent2.getNode(), Individual::getCrossMask(), node);
+    for (auto& m : Individual::getMutLog())
+        genealogy->addMutation(node, m.locus, m.stoch, m.value);
+    Individual::getMutLog().clear();
+}
+
+// Simplify to ancestry of this population, which must be the current one, and renumber its nodes
+
+void Population::simplifyGenealogy()
+{
+    std::vector<int> samples(popSize);
+    for (int i = 0; i < popSize; ++i)
+        samples[i] = ind[i].getNode();
+    auto newIds = genealogy->simplify(samples);
+    for (int i = 0; i < popSize; ++i)
+        ind[i].setNode(newIds[i]);
+}
+
 // If using stochastic loci for phenotypic variability, then simply double number of loci for allocation of vectors and matrix, and use 1..L for genotype and L+1,...,2L for stochastic alleles
 
-void Population::calcStats(Param& param, SumStat& stats)
+void Population::calcStats(Param& param, SumStat& stats, PopColumns *dump)
 {
     int i, j;
     int loci = param.loci;
@@ -138,10 +274,16 @@ void Population::calcStats(Param& param, SumStat& stats)
     std::iota(ptiles.begin(), ptiles.end(), 0);     // assign [0..n-1] for distnSteps = n, use n = 101
     auto& gDistn = stats.getGDistn();
     auto& sDistn = stats.getSDistn();
+    // with dump, percentiles of a copy, so dumped columns keep population order even if percentiles_interpol sorts its argument
+    auto ptileOf = [&ptiles, dump](std::vector<double>& v){
+        if (!dump) return percentiles_interpol<std::vector<double>>(v, ptiles);
+        std::vector<double> copy(v);
+        return percentiles_interpol<std::vector<double>>(copy, ptiles);
+    };
 
     for (i = 0; i < loci; ++i){
-        gDistn[i] = percentiles_interpol<std::vector<double>>(gMatrix[i], ptiles);
-        if (param.stoch) sDistn[i] = percentiles_interpol<std::vector<double>>(sMatrix[i], ptiles);
+        gDistn[i] = ptileOf(gMatrix[i]);
+        if (param.stoch) sDistn[i] = ptileOf(sMatrix[i]);
     }
     
     // fitness distn
@@ -151,7 +293,7 @@ void Population::calcStats(Param& param, SumStat& stats)
     stats.setSDFitness(vecSD<double>(indFitness, mean));
     
     auto& fitnessDistn = stats.getFitnessDistn();
-    fitnessDistn = percentiles_interpol<std::vector<double>>(indFitness, ptiles);
+    fitnessDistn = ptileOf(indFitness);
     
     // perf distn
     
@@ -164,7 +306,7 @@ void Population::calcStats(Param& param, SumStat& stats)
     stats.setSDPerf(vecSD<double>(indPerf, pmean));
     
     auto& perfDistn = stats.getPerfDistn();
-    perfDistn = percentiles_interpol<std::vector<double>>(indPerf, ptiles);
+    perfDistn = ptileOf(indPerf);
     
     // fitness repeatability of low-performing individuals
     
@@ -194,13 +336,29 @@ void Population::calcStats(Param& param, SumStat& stats)
         stats.setLowFitPtile((100.0*thresholdIndex)/static_cast<double>(popSize));
         stats.setLowFitRepeat(static_cast<double>(numBelowThreshold)/samples);
     }
+
+    // columns in order of population before sort, see PopDump.h
+    if (dump){
+        for (i = 0; i < loci; ++i){
+            dump->names.push_back(fmt::format("g{}", i));
+            dump->cols.push_back(std::move(gMatrix[i]));
+        }
+        for (i = 0; i < loci && param.stoch; ++i){
+            dump->names.push_back(fmt::format("s{}", i));
+            dump->cols.push_back(std::move(sMatrix[i]));
+        }
+        dump->names.push_back("fitness");
+        dump->cols.push_back(indFitness);
+        dump->names.push_back("J");
+        dump->cols.push_back(std::move(indPerf));
+    }
 }
 
 // Alias method for sampling from discrete distribution, see https://pandasthumb.org/archives/2012/08/lab-notes-the-a.html and https://en.wikipedia.org/wiki/Alias_method and http://www.keithschwarz.com/darts-dice-coins/
 // Example code for testing in ~/sim/02_SmallTests/aliasMethod.cc
 
 uint32_t Population::getRandIndex(){
-    uint64_t u = rnd.rawint();
+    uint64_t u = rndStreams.select->rawint();
     uint32_t x = u % popSize;
     return (u < hvec[x]) ? x : avec[x];
 }
@@ -216,9 +374,15 @@ void Population::createAliasTable() {
     std::vector<double> p(n);
     for (uint32_t i = 0; i < n; ++i)
         f += pp[i];
-    f = static_cast<double>(n) / f;
-    for (uint32_t i = 0; i < n; ++i)
-        p[i] = pp[i] * f;
+    if (f > 0.0 && std::isfinite(f)){
+        f = static_cast<double>(n) / f;
+        for (uint32_t i = 0; i < n; ++i)
+            p[i] = pp[i] * f;
+    }
+    else{       // degenerate fitness, choose individuals uniformly as in ClonePopulation::reproduce
+        for (uint32_t i = 0; i < n; ++i)
+            p[i] = 1.0;
+    }
     
     // find starting positions, g => less than target, m greater than target
     uint32_t g, m, mm;
@@ -5,6 +5,10 @@
 #include "typedefs.h"
 #include "Individual.h"
 #include "SumStat.h"
+#include "Genealogy.h"
+#include "Performance.h"
+#include "Equilibrium.h"
+#include "PopDump.h"
 
 // Life cycle is make a baby, mutate the baby, calculate its fitness,
 // analyze the population characteristics every so often, reproduce
@@ -12,26 +16,40 @@
 class Population
 {
 public:
-	Population(Param& param);
+	Population(Param& param, bool init = true);  // init false => allocate only, set individuals later
 	int			getPopSize(){return popSize;}
 	Individual&	getInd(int i){return ind[i];}
+    Individual& sampleInd(size_t k, size_t n){return ind[k*ind.size()/n];}  // k-th of n evenly spaced, for analyses of final population
     Individual& chooseInd(){return ind[getRandIndex()];}
     void        partialSortInd(unsigned long sortToIndex);  // sort first percent of individuals by fitness
     void        fullSortInd();                              // sort all individuals by fitness
     void		setFitnessArray();
+    void        recalcFitness();
+    double      fidelityChange(const Fidelity& lo, const Fidelity& hi, unsigned long seed);
+    GenStats    genStats(bool alleles);                     // fitness from fitness array, alleles => gVar too
+    void        memoryRanges(std::vector<std::pair<const void *, size_t>>& r);  // buffers and alleles, see Numa.h
+    auto&       getIndividuals(){return ind;}
+    void        setIndividuals(const std::vector<Individual>& other){ind = other;}
 	void		reproduceMutateCalcFit(Population& oldPop);
     void        reproduceNoMutRec(Population& oldPop);
-    void		calcStats(Param& param, SumStat& stats);
+    void		calcStats(Param& param, SumStat& stats, PopColumns *dump = nullptr);    // dump => columns moved there
     void        createAliasTable();
+    auto        getSetBaby(){return SetBaby;}
+    void        setGenealogy(Genealogy* g){genealogy = g;}
+    void        recordFounders();
+    void        simplifyGenealogy();
 private:
+    void        recordBirth(Individual& parent1, Individual& parent2, Individual& baby);
     int     	chooseMember(double *array, int n);
 	int 		popSize;
+    int         numLoci;
     std::vector<Individual>	ind;			// vector of individuals
     std::vector<double>		indFitness;     // fitness of individuals
     std::vector<uint64_t>   hvec;
     std::vector<uint32_t>   avec;
     uint32_t getRandIndex();
     void (*SetBaby)(Individual&, Individual&, Individual&);
+    Genealogy*  genealogy = nullptr;        // if not null, record births and mutations
 };
 
 #endif
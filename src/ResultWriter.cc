@@ -0,0 +1,122 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <bzlib.h>
+
+#include "ResultWriter.h"
+#include "Numa.h"
+#include APPL_H
+
+ResultWriter::ResultWriter(const std::string& filename, bool c, int s, size_t m)
+    : compress(c), syncEvery(s), maxQueue(m)
+{
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        ThrowError(__FILE__, __LINE__, "Could not open " + filename + ": " + strerror(errno));
+    writer = std::thread(&ResultWriter::run, this);
+}
+
+ResultWriter::~ResultWriter()
+{
+    // destructor may run during exception unwinding, so do not rethrow writer errors here
+    try {close();}
+    catch (...) {}
+}
+
+void ResultWriter::push(std::string result, std::function<void()> ledger)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    notFull.wait(lock, [this]{return queue.size() < maxQueue || error;});
+    if (error) rethrow();
+    queue.push_back({std::move(result), std::move(ledger)});
+    notEmpty.notify_one();
+}
+
+void ResultWriter::close()
+{
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+    }
+    notEmpty.notify_one();
+    writer.join();
+    int syncErr = (syncEvery > 0 && unsynced > 0 && fsync(fd) != 0) ? errno : 0;
+    ::close(fd);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (error) rethrow();
+    if (syncErr != 0)
+        ThrowError(__FILE__, __LINE__, std::string("fsync of output failed: ") + strerror(syncErr));
+}
+
+void ResultWriter::rethrow()
+{
+    auto e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+}
+
+void ResultWriter::run()
+{
+    NumaWidenThread();      // thread inherits the pin of the compute thread, see Numa.h
+    while (true){
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            notEmpty.wait(lock, [this]{return !queue.empty() || done;});
+            if (queue.empty()) return;
+            item = std::move(queue.front());
+            queue.pop_front();
+        }
+        notFull.notify_one();
+        try {
+            write(item.result);
+            if (item.ledger) item.ledger();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            error = std::current_exception();
+            queue.clear();
+            notFull.notify_one();
+            return;
+        }
+    }
+}
+
+void ResultWriter::write(const std::string& result)
+{
+    if (result.empty()) return;         // run without output of its own, eg, replicate being aggregated
+    if (compress){
+        // worst case bzip2 output is 1% larger than input plus 600 bytes
+        auto inSize = static_cast<unsigned>(result.size());
+        unsigned outSize = inSize + inSize/100 + 601;
+        std::vector<char> out(outSize);
+        int status = BZ2_bzBuffToBuffCompress(out.data(), &outSize, const_cast<char *>(result.data()),
+                                              inSize, 9, 0, 0);
+        if (status != BZ_OK)
+            ThrowError(__FILE__, __LINE__, fmt::format("bzip2 compression failed with status {}", status));
+        writeAll(out.data(), outSize);
+    }
+    else
+        writeAll(result.data(), result.size());
+    if (syncEvery > 0 && ++unsynced >= syncEvery){
+        if (fsync(fd) != 0)
+            ThrowError(__FILE__, __LINE__, std::string("fsync of output failed: ") + strerror(errno));
+        unsynced = 0;
+    }
+}
+
+void ResultWriter::writeAll(const char *buf, size_t n)
+{
+    while (n > 0){
+        auto w = ::write(fd, buf, n);
+        if (w < 0){
+            if (errno == EINTR) continue;
+            ThrowError(__FILE__, __LINE__, std::string("Write of output failed: ") + strerror(errno));
+        }
+        buf += w;
+        n -= static_cast<size_t>(w);
+    }
+}
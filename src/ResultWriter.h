@@ -0,0 +1,47 @@
+#ifndef _ResultWriter_h
+#define _ResultWriter_h 1
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+// Background writer for run results. Compute thread pushes each completed result with a ledger action, which updates input/random.<host>; writer thread appends result to output file and then runs ledger action, so ledger never claims a run whose result has not been written. Queue is bounded, push blocks only when writer falls maxQueue results behind.
+
+// If compress, each result is written as a complete bzip2 stream, so file is a sequence of concatenated streams, read by bzip2 -d and python bz2.open. Every run on disk is complete after each push is handled, so restarting from ledger loses nothing.
+
+// syncEvery > 0 => fsync output file after every syncEvery results, 0 => leave flushing to OS
+
+// Errors on writer thread are rethrown on compute thread at next push or at close.
+
+class ResultWriter
+{
+public:
+    ResultWriter(const std::string& filename, bool compress, int syncEvery, size_t maxQueue = 8);
+    ~ResultWriter();
+    void        push(std::string result, std::function<void()> ledger);
+    void        close();
+private:
+    struct Item {std::string result; std::function<void()> ledger;};
+    void        run();
+    void        write(const std::string& result);
+    void        writeAll(const char *buf, size_t n);
+    void        rethrow();
+    int         fd;
+    bool        compress;
+    int         syncEvery;
+    int         unsynced = 0;
+    size_t      maxQueue;
+    bool        done = false;
+    std::deque<Item>        queue;
+    std::mutex              mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::exception_ptr      error;
+    std::thread             writer;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#include "Robustness.h"
+#include "Evaluate.h"
+#include "ThreadPool.h"
+#include "Numa.h"
+
+const int noiseDraws = 64;
+const double unstableJ = 1e19;      // performance() returns 1e20 for unstable systems
+
+// with NUMA placement, one worker per cpu of the node of the run, see Numa.h
+
+ThreadPool& ScanPool()
+{
+    static ThreadPool pool((NumaOn()) ? static_cast<unsigned>(NumaNodeCpus().size())
+                           : std::max(1u, std::thread::hardware_concurrency()), NumaPinWorker);
+    return pool;
+}
+
+// Evaluate rows in blocks on the pool; row numbers set seeds, see EvalBatch
+
+void EvalRows(const std::vector<Allele>& g, const std::vector<Allele>& s, int loci, const EvalParam& p,
+              unsigned long seed, std::vector<double>& J)
+{
+    auto L = static_cast<size_t>(loci);
+    size_t rows = g.size()/L;
+    J.resize(rows);
+    std::vector<double> fitness(rows);
+    ScanPool().run(rows, [&](size_t first, size_t last){
+        EvalBatch(&g[first*L], (p.stoch) ? &s[first*L] : nullptr, loci, last - first, p, seed, first,
+                  &J[first], &fitness[first]);
+    });
+}
+
+double SortedPercentile(const std::vector<double>& x, double q)
+{
+    double r = q*static_cast<double>(x.size() - 1);
+    auto i = static_cast<size_t>(r);
+    double f = r - static_cast<double>(i);
+    return (i + 1 < x.size()) ? x[i] + f*(x[i+1] - x[i]) : x[i];
+}
+
+// mean, sd, then 5, 25, 50, 75, 95 percentiles by linear interpolation; nan values dropped
+
+std::string RobustnessRow(const std::string& label, std::vector<double> x)
+{
+    x.erase(std::remove_if(x.begin(), x.end(), [](double v){return std::isnan(v);}), x.end());
+    std::string out = fmt::format("{:>5}", label);
+    if (x.empty()) return out + "  no stable values\n";
+    std::sort(x.begin(), x.end());
+    double n = static_cast<double>(x.size()), m = 0.0, v = 0.0;
+    for (auto y : x) m += y;
+    m /= n;
+    for (auto y : x) v += (y - m)*(y - m);
+    out += fmt::format("{:11.3e}{:11.3e}", m, (x.size() > 1) ? sqrt(v/(n - 1.0)) : 0.0);
+    for (double q : {0.05, 0.25, 0.5, 0.75, 0.95}) out += fmt::format("{:11.3e}", SortedPercentile(x, q));
+    return out + "\n";
+}
+
+std::string RobustnessScan(Population& pop, Param& param)
+{
+    auto& p = Individual::getEvalParam();
+    EvalParam det = EvalNominal(p);
+    bool noise = p.stoch || std::abs(p.aSD) > 1e-6;
+    int loci = param.loci;
+    auto L = static_cast<size_t>(loci);
+    auto n = static_cast<size_t>(std::min(param.robust, pop.getPopSize()));
+    size_t pairs = L*(L - 1)/2;
+    size_t perInd = 1 + 2*L + pairs;        // g, g +/- e_i, g + e_i + e_j
+    Allele d = param.mutStep;
+
+    std::vector<Allele> rows, noiseG, noiseS;
+    rows.reserve(n*perInd*L);
+    for (size_t k = 0; k < n; ++k){
+        auto& ind = pop.sampleInd(k, n);
+        const Allele *g = ind.getGenotype().get();
+        auto row = [&](long i, Allele di, long j, Allele dj){
+            auto start = rows.size();
+            rows.insert(rows.end(), g, g + L);
+            if (i >= 0) rows[start + static_cast<size_t>(i)] += di;
+            if (j >= 0) rows[start + static_cast<size_t>(j)] += dj;
+        };
+        row(-1, 0, -1, 0);
+        for (long i = 0; i < loci; ++i){
+            row(i, d, -1, 0);
+            row(i, -d, -1, 0);
+        }
+        for (long i = 0; i < loci; ++i)
+            for (long j = i + 1; j < loci; ++j)
+                row(i, d, j, d);
+        if (noise){
+            for (int r = 0; r < noiseDraws; ++r){
+                noiseG.insert(noiseG.end(), g, g + L);
+                if (p.stoch) noiseS.insert(noiseS.end(), ind.getStochast().get(), ind.getStochast().get() + L);
+            }
+        }
+    }
+    std::vector<double> J, noiseJ;
+    EvalRows(rows, {}, loci, det, 0, J);
+    if (noise) EvalRows(noiseG, noiseS, loci, p, RowSeed(param.rndSeed, 4), noiseJ);
+
+    const double nan = std::nan("");
+    auto stable = [](std::initializer_list<double> v){
+        return std::all_of(v.begin(), v.end(), [](double x){return x < unstableJ;});
+    };
+    std::vector<std::vector<double>> sens(L);
+    std::vector<double> all(n), noiseSD(n, nan);
+    std::vector<std::vector<double>> epi(L, std::vector<double>(L, 0.0));
+    std::vector<std::vector<int>> epiN(L, std::vector<int>(L, 0));
+    int unstable = 0;
+    for (size_t k = 0; k < n; ++k){
+        const double *Jk = &J[k*perInd];
+        double J0 = Jk[0];
+        double sum = 0.0;
+        for (size_t i = 0; i < L; ++i){
+            double jp = Jk[1 + 2*i], jm = Jk[2 + 2*i];
+            if (stable({J0, jp, jm})){
+                sens[i].push_back(0.5*(std::abs(jp - J0) + std::abs(jm - J0)));
+                sum += sens[i].back();
+                epi[i][i] += jp + jm - 2.0*J0;
+                ++epiN[i][i];
+            }
+            else{
+                sens[i].push_back(nan);
+                sum = nan;
+                ++unstable;
+            }
+        }
+        all[k] = sum/static_cast<double>(L);
+        const double *pair = Jk + 1 + 2*L;
+        for (size_t i = 0; i < L; ++i){
+            for (size_t j = i + 1; j < L; ++j, ++pair){
+                double ji = Jk[1 + 2*i], jj = Jk[1 + 2*j];
+                if (stable({J0, ji, jj, *pair})){
+                    epi[i][j] += *pair - ji - jj + J0;
+                    ++epiN[i][j];
+                }
+                else ++unstable;
+            }
+        }
+        if (noise){
+            double m = 0.0, v = 0.0;
+            int c = 0;
+            for (int r = 0; r < noiseDraws; ++r){
+                double x = noiseJ[k*noiseDraws + static_cast<size_t>(r)];
+                if (x >= unstableJ){
+                    ++unstable;
+                    continue;
+                }
+                ++c;
+                double dx = x - m;
+                m += dx/c;
+                v += dx*(x - m);
+            }
+            if (c > 1) noiseSD[k] = sqrt(v/(c - 1));
+        }
+    }
+
+    std::string out = fmt::format("Robustness of J, {} individuals, loci moved by +/- {:.3e}, {} noise draws\n\n",
+                                  n, d, (noise) ? noiseDraws : 0);
+    out += fmt::format("{:>5}", "");
+    for (auto s : {"Mean", "SD", "5%", "25%", "50%", "75%", "95%"}) out += fmt::format("{:>11}", s);
+    out += "\n";
+    for (size_t i = 0; i < L; ++i)
+        out += RobustnessRow(fmt::format("g{}", i), sens[i]);
+    out += RobustnessRow("all", all);
+    if (noise) out += RobustnessRow("noise", noiseSD);
+    out += fmt::format("\nEpistasis of J, mean over individuals, diagonal is curvature; unstable = {}\n\n", unstable);
+    out += "     ";
+    for (size_t i = 0; i < L; ++i) out += fmt::format((i < 10) ? "{:>10}{:1}" : "{:>9}{:2}", "g", i);
+    out += "\n";
+    for (size_t i = 0; i < L; ++i){
+        out += fmt::format((i < 10) ? "{:>4}{:1}" : "{:>3}{:2}", "g", i);
+        for (size_t j = 0; j < L; ++j){
+            auto a = std::min(i, j), b = std::max(i, j);
+            out += fmt::format("{:11.3e}", (epiN[a][b] > 0) ? epi[a][b]/epiN[a][b] : nan);
+        }
+        out += "\n";
+    }
+    return out + "\n\n";
+}
@@ -0,0 +1,22 @@
+#ifndef _Robustness_h
+#define _Robustness_h 1
+
+#include <string>
+#include <vector>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Population.h"
+
+// Robustness scan of final population, param robust > 0 individuals, evenly spaced in population order, which is random after reproduction, so no random numbers drawn from rnd.
+
+// For each sampled individual, J without aSD or stochWt noise at genotype g, at g with each locus moved by +/- mutStep, and at g with each pair of loci moved by + mutStep. Mutational sensitivity of locus i is mean |J(g +/- e_i) - J(g)|; epistasis of loci i, j is J(g+e_i+e_j) - J(g+e_i) - J(g+e_j) + J(g), diagonal is curvature J(g+e_i) + J(g-e_i) - 2J(g). With aSD or stochWt, noise sensitivity is SD of J over noiseDraws evaluations of g with noise, streams from RowSeed(rndSeed, 4) by row as in EvalBatch.
+
+// All evaluations go through EvalBatch on a persistent thread pool, so cost is divided among cores. Quantities that involve an unstable system, J = 1e20, are left out and counted.
+
+std::string RobustnessScan(Population& pop, Param& param);
+// label, then mean, sd, 5, 25, 50, 75, 95 percentiles of x, nan values dropped; also used by FreqResponse
+std::string RobustnessRow(const std::string& label, std::vector<double> x);
+double      SortedPercentile(const std::vector<double>& x, double q);  // q in [0, 1] of sorted x, by linear interpolation
+
+#endif
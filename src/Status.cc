@@ -0,0 +1,118 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+
+#include "Status.h"
+#include APPL_H
+
+Status status;
+
+// Status is optional, so failure to create the segment is reported and ignored
+
+void Status::open(const std::string& tag, int firstRun, int lastRun)
+{
+#ifdef __linux__
+    path = fmt::format("/dev/shm/sensitivity.status.{}", getpid());
+#else
+    path = fmt::format("/tmp/sensitivity.status.{}", getpid());
+#endif
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(StatusData)) != 0){
+        std::cerr << fmt::format("Status: could not create {}: {}\n", path, strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+    void *p = mmap(nullptr, sizeof(StatusData), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED){
+        std::cerr << fmt::format("Status: could not map {}: {}\n", path, strerror(errno));
+        unlink(path.c_str());
+        return;
+    }
+    // file is zero filled by ftruncate, set fields before magic so reader never sees partial header
+    data = static_cast<StatusData *>(p);
+    strncpy(data->tag, tag.c_str(), sizeof(data->tag) - 1);
+    data->pid = getpid();
+    data->firstRun = firstRun;
+    data->lastRun = lastRun;
+    data->runNum = firstRun;
+    data->startNs = now();
+    data->updateNs = data->startNs.load();
+    data->version = StatusData::versionNumber;
+    data->magic.store(StatusData::magicNumber, std::memory_order_release);
+    phaseStart = clock::now();
+}
+
+void Status::close()
+{
+    if (!data) return;
+    munmap(data, sizeof(StatusData));
+    unlink(path.c_str());
+    data = nullptr;
+}
+
+uint64_t Status::now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void Status::startRun(int runNum, int totalGen)
+{
+    if (!data) return;
+    begin();
+    data->runNum.store(runNum, std::memory_order_relaxed);
+    data->gen.store(0, std::memory_order_relaxed);
+    data->totalGen.store(totalGen, std::memory_order_relaxed);
+    data->runStartNs.store(now(), std::memory_order_relaxed);
+    end();
+    phase(StatusData::init);
+}
+
+void Status::generation(int gen, uint64_t evals)
+{
+    if (!data) return;
+    begin();
+    data->gen.store(gen, std::memory_order_relaxed);
+    data->evals.fetch_add(evals, std::memory_order_relaxed);
+    data->updateNs.store(now(), std::memory_order_relaxed);
+    end();
+}
+
+void Status::table(uint64_t lookups, uint64_t misses)
+{
+    if (!data) return;
+    begin();
+    data->tblLookups.store(runLookups + lookups, std::memory_order_relaxed);
+    data->tblMisses.store(runMisses + misses, std::memory_order_relaxed);
+    end();
+}
+
+// add time since last change to current phase, then switch
+
+void Status::phase(int p)
+{
+    if (!data) return;
+    auto t = clock::now();
+    auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t - phaseStart).count());
+    phaseStart = t;
+    begin();
+    data->phaseNs[current].fetch_add(ns, std::memory_order_relaxed);
+    data->phase.store(p, std::memory_order_relaxed);
+    data->updateNs.store(now(), std::memory_order_relaxed);
+    end();
+    current = p;
+}
+
+void Status::endRun()
+{
+    if (!data) return;
+    runLookups = data->tblLookups.load(std::memory_order_relaxed);
+    runMisses = data->tblMisses.load(std::memory_order_relaxed);
+    begin();
+    data->runsDone.fetch_add(1, std::memory_order_relaxed);
+    data->gen.store(data->totalGen.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    end();
+}
@@ -0,0 +1,67 @@
+#ifndef _Status_h
+#define _Status_h 1
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+// Live status of a running process in a small file mapped into shared memory, /dev/shm/sensitivity.status.<pid> on Linux, /tmp on other systems. Read by scripts/statusLocal.py, which aggregates all processes on a node without signals, logs or ssh.
+
+// Writer is only the compute thread. Updates are a seqlock: seq is odd while fields change, so a reader copies the block and retries if seq was odd or changed. All fields are 8 byte atomics with relaxed stores, so an update costs a few plain stores; LifeCycle updates once per generation, not per evaluation.
+
+// Layout is read by statusLocal.py, change version there and here together.
+
+struct StatusData {
+    static constexpr uint64_t magicNumber = 0x54415453534e4553ULL;  // "SENSSTAT" little endian
+    static constexpr uint64_t versionNumber = 1;
+    enum {init, evolve, stats, write, phases};
+    std::atomic<uint64_t>   magic;
+    std::atomic<uint64_t>   version;
+    std::atomic<uint64_t>   seq;
+    std::atomic<int64_t>    pid;
+    char                    tag[64];        // outputTag, written before magic
+    std::atomic<int64_t>    firstRun;
+    std::atomic<int64_t>    lastRun;
+    std::atomic<int64_t>    runNum;
+    std::atomic<int64_t>    runsDone;
+    std::atomic<int64_t>    gen;
+    std::atomic<int64_t>    totalGen;
+    std::atomic<uint64_t>   evals;          // exact J evaluations, all runs; J table and surrogate answers not counted
+    std::atomic<uint64_t>   tblLookups;     // J table, all runs
+    std::atomic<uint64_t>   tblMisses;
+    std::atomic<uint64_t>   startNs;        // wall clock, ns since epoch
+    std::atomic<uint64_t>   runStartNs;
+    std::atomic<uint64_t>   updateNs;
+    std::atomic<int64_t>    phase;          // current phase
+    std::atomic<uint64_t>   phaseNs[phases];    // cumulative time in each phase
+};
+
+class Status
+{
+public:
+    ~Status(){close();}
+    void    open(const std::string& tag, int firstRun, int lastRun);
+    void    close();
+    bool    isOpen(){return data != nullptr;}
+    void    startRun(int runNum, int totalGen);
+    void    generation(int gen, uint64_t evals);    // evals since last call
+    void    table(uint64_t lookups, uint64_t misses);   // cumulative for current run
+    void    phase(int p);
+    void    endRun();
+private:
+    using clock = std::chrono::steady_clock;
+    void    begin(){data->seq.fetch_add(1, std::memory_order_relaxed); std::atomic_thread_fence(std::memory_order_release);}
+    void    end(){std::atomic_thread_fence(std::memory_order_release); data->seq.fetch_add(1, std::memory_order_relaxed);}
+    uint64_t    now();
+    StatusData  *data = nullptr;
+    std::string path;
+    int         current = StatusData::init;
+    clock::time_point phaseStart;
+    uint64_t    runLookups = 0;             // table counts at end of previous runs
+    uint64_t    runMisses = 0;
+};
+
+extern Status status;
+
+#endif
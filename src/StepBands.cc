@@ -0,0 +1,63 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include "StepBands.h"
+#include "P2Quantile.h"
+#include "Evaluate.h"
+#include "Performance.h"
+
+const double tmax = 20.0;           // as in EvalJ
+const int gridSteps = 40;
+const double bandProb[] = {0.05, 0.25, 0.5, 0.75, 0.95};
+
+std::string StepBands(Population& pop, Param& param)
+{
+    EvalParam det = EvalNominal(Individual::getEvalParam());
+    signalType ctrlType = (det.loop == Loop::open) ? signalType::controlOpen : signalType::controlClosed;
+    auto total = static_cast<size_t>(std::min(param.stepBands, pop.getPopSize()));
+
+    std::vector<double> t(gridSteps + 1);
+    for (int j = 0; j <= gridSteps; ++j) t[static_cast<size_t>(j)] = tmax*j/gridSteps;
+    // estimator for each signal, time and percentile, in that order
+    std::vector<P2Quantile> band;
+    for (int k = 0; k < 2*(gridSteps + 1); ++k)
+        for (double p : bandProb) band.emplace_back(p);
+    const size_t P = std::size(bandProb);
+
+    SAFrand_pcg<pcgT> r;        // no noise, so no draws
+    std::vector<double> num, den, y;
+    int unstable = 0, failed = 0;
+    for (size_t k = 0; k < total; ++k){
+        auto& ind = pop.sampleInd(k, total);
+        double a = EvalTransfer(ind.getGenotype().get(), nullptr, det, r, num, den);
+        if (MaxRootRealPart(den) > -1e-6){
+            ++unstable;
+            continue;
+        }
+        unsigned long outTerms = (det.ctrlOrder != 2 || det.plantOrder != 2) ? num.size() : 3;
+        if (!stepResponse(num, CtrlNumerator(num, den, PlantDen(a, det.plantOrder)), den, ctrlType, t, y, outTerms)){
+            ++failed;
+            continue;
+        }
+        for (size_t i = 0; i < y.size(); ++i)
+            for (size_t m = 0; m < P; ++m) band[i*P + m].add(y[i]);
+    }
+
+    std::string out = fmt::format("Step response bands, {} individuals, {} unstable, {} failed integration\n\n",
+                                  total, unstable, failed);
+    if (band[0].getN() == 0) return out + "No stable individuals\n\n\n";
+    out += fmt::format("{:>7}", "t");
+    for (auto s : {"y 5%", "25%", "50%", "75%", "95%", "u 5%", "25%", "50%", "75%", "95%"})
+        out += fmt::format("{:>11}", s);
+    out += "\n";
+    for (size_t j = 0; j < t.size(); ++j){
+        out += fmt::format("{:7.2f}", t[j]);
+        for (size_t s = 0; s < 2; ++s)
+            for (size_t m = 0; m < P; ++m)
+                out += fmt::format("{:11.3e}", band[(s*t.size() + j)*P + m].get());
+        out += "\n";
+    }
+    return out + "\n\n";
+}
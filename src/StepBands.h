@@ -0,0 +1,16 @@
+#ifndef _StepBands_h
+#define _StepBands_h 1
+
+#include <string>
+
+#include APPL_H
+#include "typedefs.h"
+#include "Population.h"
+
+// Percentile bands of step response of final population, param stepBands > 0 individuals, evenly spaced in population order as for RobustnessScan. Transfer functions from EvalTransfer without aSD or stochWt noise, so bands show how genotypic variation becomes variation of dynamics.
+
+// Each individual takes one native integration, stepResponse, sampled on a fixed grid of t over [0, tmax] of J, for output y and control signal u = num (1 + a s + s^2)/den as in EvalJ. Values at each grid time go to P^2 estimators of the 5, 25, 50, 75 and 95 percentiles, so memory is O(grid), not O(individuals x grid). Individuals with unstable den or failed integration are left out and counted.
+
+std::string StepBands(Population& pop, Param& param);
+
+#endif
@@ -17,3 +17,43 @@ void SumStat::initialize(Param& param)
         sgCorr = std::vector<std::vector<double>>(loci, std::vector<double>(loci));
     }
 }
+
+// Fields printed by PrintSummary, excluding genealogy, visited in a fixed order. Used to aggregate replicates field by field.
+
+template <class F>
+void SumStat::forEach(F f)
+{
+    f(aveFitness);
+    f(sdFitness);
+    for (auto& x : fitnessDistn) f(x);
+    f(lowFitCutoff);
+    f(lowFitPtile);
+    f(lowFitRepeat);
+    f(avePerf);
+    f(sdPerf);
+    for (auto& x : perfDistn) f(x);
+    for (auto* m : {&gMean, &gSD, &sMean, &sSD})
+        for (auto& x : *m) f(x);
+    for (auto* t : {&gDistn, &gCorr, &sDistn, &sCorr, &sgCorr})
+        for (auto& row : *t)
+            for (auto& x : row) f(x);
+}
+
+std::vector<double> SumStat::toVector()
+{
+    std::vector<double> v;
+    forEach([&v](double& x){v.push_back(x);});
+    return v;
+}
+
+void SumStat::fromVector(const std::vector<double>& v)
+{
+    size_t i = 0;
+    forEach([&v, &i](double& x){
+        if (i >= v.size())
+            ThrowError(__FILE__, __LINE__, "SumStat::fromVector: too few values");
+        x = v[i++];
+    });
+    if (i != v.size())
+        ThrowError(__FILE__, __LINE__, "SumStat::fromVector: too many values");
+}
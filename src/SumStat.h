@@ -35,7 +35,16 @@ public:
     double      getLowFitPtile(){return lowFitPtile;}
     void        setLowFitRepeat(double x){lowFitRepeat = x;}
     double      getLowFitRepeat(){return lowFitRepeat;}
+    void        setGenealogy(ulong n, ulong e, ulong m, std::vector<int> t)
+                    {genNodes = n; genEdges = e; genMuts = m; tmrca = t;}
+    ulong       getGenNodes(){return genNodes;}
+    ulong       getGenEdges(){return genEdges;}
+    ulong       getGenMuts(){return genMuts;}
+    auto&       getTMRCA(){return tmrca;}
+    std::vector<double> toVector();                     // printed fields in fixed order, see forEach
+    void        fromVector(const std::vector<double>& v);   // shape from current fields, eg, copy of a run
 private:
+    template <class F> void forEach(F f);
     std::vector<double> gMean;                  // mean values of alleles
     std::vector<double> gSD;                    // sd values of alleles
     std::vector<std::vector<double>> gDistn;    // percentiles [0..100]  of alleles
@@ -56,6 +65,10 @@ private:
     double      lowFitRepeat;
     std::vector<double> fitnessDistn;
     std::vector<double> perfDistn;
+    ulong       genNodes = 0;   // size of genealogy tables after final simplify
+    ulong       genEdges = 0;
+    ulong       genMuts = 0;
+    std::vector<int> tmrca;     // time to most recent common ancestor by locus, -1 => not coalesced
 };
 
 #endif
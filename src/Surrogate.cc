@@ -0,0 +1,166 @@
+#include <cmath>
+#include <algorithm>
+
+#include "Surrogate.h"
+
+void Surrogate::build(int dims, double errTol)
+{
+    d = dims;
+    tol = errTol;
+    reset();
+    x.reserve(capacity*static_cast<size_t>(d));
+    J.reserve(capacity);
+    lookups = exactCount = audits = badAudits = 0;
+    maxAuditErr = sumSqAuditErr = 0.0;
+    suspended = false;
+    on = true;
+}
+
+double Surrogate::getJ(const Allele *g, const std::function<double()>& exact)
+{
+    ++lookups;
+    double y;
+    if (!suspended){
+        int hit = predict(g, y);
+        if (hit == stored || (hit == fitted && rndStreams.perturb->rU01() >= auditFraction)) return y;
+        if (hit == fitted){
+            double e = exact();
+            double err = std::abs(e - y);
+            ++exactCount;
+            ++audits;
+            maxAuditErr = std::max(maxAuditErr, err);
+            sumSqAuditErr += err*err;
+            if (err > badFactor*tol) ++badAudits;
+            if (audits >= minAudits && static_cast<double>(badAudits) > maxBadFraction*static_cast<double>(audits)){
+                suspended = true;
+                if (showProgress)
+                    std::cout << fmt::format("Surrogate: {} of {} audits with error > {:.3e}, switched off\n",
+                                             badAudits, audits, badFactor*tol);
+            }
+            add(g, e);
+            return e;
+        }
+    }
+    ++exactCount;
+    y = exact();
+    if (!suspended) add(g, y);
+    return y;
+}
+
+void Surrogate::add(const Allele *g, double y)
+{
+    if (J.size() < capacity){
+        x.insert(x.end(), g, g + d);
+        J.push_back(y);
+    }
+    else{
+        std::copy(g, g + d, x.begin() + static_cast<long>(next*d));
+        J[next] = y;
+        next = (next + 1) % capacity;
+    }
+}
+
+// Local fit centered at query, coordinates scaled by neighborhood radius so normal equations are well conditioned. Unknowns are value, gradient and diagonal of Hessian at query, p = 2d + 1, with k = 2p + 2 neighbors to leave degrees of freedom for the residual. Solve by Cholesky, then also solve for first column of inverse, which gives variance of fitted value.
+
+int Surrogate::predict(const Allele *g, double& y)
+{
+    auto p = static_cast<size_t>(2*d + 1);
+    size_t k = 2*p + 2;
+    size_t n = J.size();
+    if (n < 2*k) return none;
+    auto D = static_cast<size_t>(d);
+    dist.resize(n);
+    order.resize(n);
+    for (size_t i = 0; i < n; ++i){
+        const double *xi = &x[i*D];
+        double s = 0.0;
+        for (size_t j = 0; j < D; ++j){
+            double u = xi[j] - g[j];
+            s += u*u;
+        }
+        dist[i] = s;
+        order[i] = i;
+    }
+    std::nth_element(order.begin(), order.begin() + static_cast<long>(k - 1), order.end(),
+                     [this](size_t a, size_t b){return dist[a] < dist[b];});
+    size_t nearest = order[0];
+    std::vector<double> centroid(D, 0.0);
+    for (size_t m = 0; m < k; ++m){
+        auto i = order[m];
+        if (J[i] >= unstableJ) return none;
+        if (dist[i] < dist[nearest]) nearest = i;
+        for (size_t j = 0; j < D; ++j) centroid[j] += x[i*D + j];
+    }
+    if (dist[nearest] == 0.0){
+        y = J[nearest];
+        return stored;
+    }
+    double r = 1.0001*sqrt(dist[order[k-1]]);
+    double c = 0.0;
+    for (size_t j = 0; j < D; ++j){
+        double u = centroid[j]/static_cast<double>(k) - g[j];
+        c += u*u;
+    }
+    if (c > 0.25*r*r) return none;          // query outside neighborhood, would extrapolate
+
+    std::vector<double> A(p*p, 0.0), b(p, 0.0), z(p), w(k);
+    for (size_t m = 0; m < k; ++m){
+        auto i = order[m];
+        double t = sqrt(dist[i])/r;
+        t = 1.0 - t*t*t;
+        w[m] = t*t*t;
+        z[0] = 1.0;
+        for (size_t j = 0; j < D; ++j){
+            z[j+1] = (x[i*D + j] - g[j])/r;
+            z[j+1+D] = z[j+1]*z[j+1];
+        }
+        for (size_t a = 0; a < p; ++a){
+            b[a] += w[m]*z[a]*J[i];
+            for (size_t e = 0; e <= a; ++e) A[a*p + e] += w[m]*z[a]*z[e];
+        }
+    }
+    // Cholesky, lower triangle of A overwritten by L
+    double ridge = 1e-12*A[0];
+    for (size_t a = 0; a < p; ++a){
+        A[a*p + a] += ridge;
+        for (size_t e = 0; e <= a; ++e){
+            double s = A[a*p + e];
+            for (size_t m = 0; m < e; ++m) s -= A[a*p + m]*A[e*p + m];
+            if (a == e){
+                if (s <= 0.0) return none;
+                A[a*p + a] = sqrt(s);
+            }
+            else
+                A[a*p + e] = s/A[e*p + e];
+        }
+    }
+    auto solve = [&](std::vector<double>& v){
+        for (size_t a = 0; a < p; ++a){
+            for (size_t m = 0; m < a; ++m) v[a] -= A[a*p + m]*v[m];
+            v[a] /= A[a*p + a];
+        }
+        for (size_t a = p; a-- > 0;){
+            for (size_t m = a + 1; m < p; ++m) v[a] -= A[m*p + a]*v[m];
+            v[a] /= A[a*p + a];
+        }
+    };
+    std::vector<double> inv0(p, 0.0);
+    inv0[0] = 1.0;
+    solve(b);
+    solve(inv0);
+    double rss = 0.0, sw = 0.0;
+    for (size_t m = 0; m < k; ++m){
+        auto i = order[m];
+        double f = b[0];
+        for (size_t j = 0; j < D; ++j){
+            double u = (x[i*D + j] - g[j])/r;
+            f += (b[j+1] + b[j+1+D]*u)*u;
+        }
+        rss += w[m]*(J[i] - f)*(J[i] - f);
+        sw += w[m];
+    }
+    double err = sqrt(rss/sw + rss/static_cast<double>(k - p)*inv0[0]);
+    if (!(err <= tol)) return none;
+    y = b[0];
+    return fitted;
+}
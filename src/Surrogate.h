@@ -0,0 +1,58 @@
+#ifndef _Surrogate_h
+#define _Surrogate_h 1
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include APPL_H
+#include "typedefs.h"
+
+// Surrogate for performance J in multi-locus deterministic mode, mutLocus < 0, aSD == 0 and stochWt == 0, so J is a smooth function of the genotype. Complements JTable, which covers single-locus mode.
+
+// Archive holds the most recent exact evaluations. For a query genotype, fit a local quadratic model without cross terms, 2*loci + 1 coefficients, to the nearest neighbors in the archive by least squares with tricube distance weights. Cross terms would need too many neighbors for 7 loci; residuals of the fit and the audits catch the curvature they miss. Predicted error is the weighted rms residual of the fit combined with the standard error of the fitted value at the query. If predicted error <= tol and the query is inside the neighborhood, return the fitted value, else evaluate exactly and add to archive. A query equal to an archived genotype, common without recombination, returns the stored exact value. Neighborhoods with an unstable system (J = 1e20) are discontinuities of J, always exact.
+
+// A random auditFraction of predictions is also evaluated exactly, and the error is tracked. If more than maxBadFraction of at least minAudits audits have error > badFactor * tol, the surrogate switches off for the rest of the run. Audit draws come from rndStreams.perturb, unused otherwise since the surrogate needs a deterministic phenotype, so paired replicates audit the same predictions.
+
+class Surrogate
+{
+public:
+    void        build(int dims, double errTol);
+    void        clear(){on = false; reset();}
+    void        reset(){x.clear(); J.clear(); next = 0;}    // drop archive, eg, after change of numerical fidelity
+    bool        isOn(){return on;}
+    double      getJ(const Allele *g, const std::function<double()>& exact);
+    auto        getLookups(){return lookups;}
+    auto        getExact(){return exactCount;}
+    auto        getAudits(){return audits;}
+    double      getMaxAuditErr(){return maxAuditErr;}
+    double      getRmsAuditErr(){return (audits > 0) ? sqrt(sumSqAuditErr/static_cast<double>(audits)) : 0.0;}
+    bool        getSuspended(){return suspended;}
+private:
+    enum        {none, fitted, stored};
+    int         predict(const Allele *g, double& y);
+    void        add(const Allele *g, double y);
+    int         d;                  // dims = loci
+    double      tol;
+    bool        on = false;
+    bool        suspended;
+    std::vector<double> x;          // archive, d values per point
+    std::vector<double> J;
+    size_t      next;               // ring buffer position once archive is full
+    std::vector<double> dist;       // work space
+    std::vector<size_t> order;
+    ulong       lookups;
+    ulong       exactCount;
+    ulong       audits;
+    ulong       badAudits;
+    double      maxAuditErr;
+    double      sumSqAuditErr;
+    static constexpr size_t capacity = 2048;
+    static constexpr double auditFraction = 1.0/32.0;
+    static constexpr double badFactor = 4.0;
+    static constexpr double maxBadFraction = 0.05;
+    static constexpr ulong  minAudits = 20;
+    static constexpr double unstableJ = 1e19;   // performance() returns 1e20 for unstable systems
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+
+#include "Sweep.h"
+
+const int designParams = 11;        // loop .. mutLocus, see GetParam
+
+AdaptiveSweep::AdaptiveSweep(const std::vector<std::string>& runLines, double prec, int b)
+    : precision(prec), budget(b)
+{
+    auto C = runLines.size();
+    if (C == 0)
+        ThrowError(__FILE__, __LINE__, "Adaptive sweep: no candidate runs");
+    std::vector<std::vector<double>> v(C, std::vector<double>(designParams));
+    runNum.resize(C);
+    for (size_t c = 0; c < C; ++c){
+        std::istringstream in(runLines[c]);
+        in >> runNum[c];
+        for (auto& d : v[c]) in >> d;
+        if (in.fail())
+            ThrowError(__FILE__, __LINE__, fmt::format("Adaptive sweep: could not read design values of run {}", c));
+    }
+    x.resize(C);
+    for (int j = 0; j < designParams; ++j){
+        double lo = v[0][j], hi = v[0][j];
+        for (auto& r : v){
+            lo = std::min(lo, r[j]);
+            hi = std::max(hi, r[j]);
+        }
+        if (hi - lo <= 1e-12*std::max(1.0, std::abs(hi))) continue;
+        bool logScale = (lo > 0.0 && hi/lo >= 4.0);
+        if (logScale){
+            lo = log(lo);
+            hi = log(hi);
+        }
+        for (size_t c = 0; c < C; ++c)
+            x[c].push_back((((logScale) ? log(v[c][j]) : v[c][j]) - lo) / (hi - lo));
+    }
+    pts.resize(C);
+
+    // farthest point from chosen set, starting nearest center
+    auto dims = x[0].size();
+    size_t n0 = std::min(C, std::max(2*dims + 1, static_cast<size_t>(budget)/4));
+    std::vector<double> dmin(C, std::numeric_limits<double>::max());
+    size_t pick = 0;
+    double best = std::numeric_limits<double>::max();
+    for (size_t c = 0; c < C; ++c){
+        double d = 0.0;
+        for (auto u : x[c]) d += (u - 0.5)*(u - 0.5);
+        if (d < best){
+            best = d;
+            pick = c;
+        }
+    }
+    while (initial.size() < n0){
+        initial.push_back(pick);
+        auto last = pick;
+        double far = -1.0;
+        for (size_t c = 0; c < C; ++c){
+            dmin[c] = std::min(dmin[c], dist(c, last));
+            if (dmin[c] > far){
+                far = dmin[c];
+                pick = c;
+            }
+        }
+        if (far <= 0.0) break;      // all candidates chosen
+    }
+}
+
+double AdaptiveSweep::dist(size_t a, size_t b)
+{
+    double d = 0.0;
+    for (size_t j = 0; j < x[a].size(); ++j)
+        d += (x[a][j] - x[b][j])*(x[a][j] - x[b][j]);
+    return sqrt(d);
+}
+
+int AdaptiveSweep::next()
+{
+    if (runs >= budget) return -1;
+    if (nextInitial < initial.size()) return static_cast<int>(initial[nextInitial++]);
+
+    std::vector<size_t> sampled;
+    for (size_t c = 0; c < pts.size(); ++c)
+        if (pts[c].n > 0) sampled.push_back(c);
+    auto K = pts[sampled[0]].mean.size();
+    // spread of sampled means and pooled within point variance for each output
+    std::vector<double> spread(K), pooled(K, 0.0);
+    int df = 0;
+    for (size_t k = 0; k < K; ++k){
+        double m = 0.0, ss = 0.0;
+        for (auto c : sampled) m += pts[c].mean[k];
+        m /= static_cast<double>(sampled.size());
+        for (auto c : sampled) ss += (pts[c].mean[k] - m)*(pts[c].mean[k] - m);
+        spread[k] = std::max(sqrt(ss/static_cast<double>(sampled.size())), 1e-12);
+    }
+    for (auto c : sampled){
+        if (pts[c].n < 2) continue;
+        df += pts[c].n - 1;
+        for (size_t k = 0; k < K; ++k) pooled[k] += pts[c].m2[k];
+    }
+    for (size_t k = 0; k < K; ++k)      // without replicates, assume noise as large as spread
+        pooled[k] = (df > 0) ? pooled[k]/df : spread[k]*spread[k];
+    // output whose spread is within twice the noise expected in sampled means is flat, nothing to resolve
+    double meanInvN = 0.0;
+    for (auto c : sampled) meanInvN += 1.0/pts[c].n;
+    meanInvN /= static_cast<double>(sampled.size());
+    std::vector<char> active(K);
+    for (size_t k = 0; k < K; ++k)
+        active[k] = (df == 0 || spread[k]*spread[k] > 2.0*pooled[k]*meanInvN);
+
+    double best = -1.0;
+    size_t pick = 0;
+    for (size_t c = 0; c < pts.size(); ++c){
+        double score = 0.0;
+        if (pts[c].n > 0){
+            for (size_t k = 0; k < K; ++k)
+                if (active[k]) score = std::max(score, sqrt(pooled[k]/pts[c].n)/spread[k]);
+        }
+        else if (sampled.size() >= 2){
+            size_t a = sampled[0], b = sampled[1];
+            if (dist(c, b) < dist(c, a)) std::swap(a, b);
+            for (size_t i = 2; i < sampled.size(); ++i){
+                auto s = sampled[i];
+                if (dist(c, s) < dist(c, a)){
+                    b = a;
+                    a = s;
+                }
+                else if (dist(c, s) < dist(c, b))
+                    b = s;
+            }
+            double dab = std::max(dist(a, b), 1e-12);
+            for (size_t k = 0; k < K; ++k)
+                if (active[k])
+                    score = std::max(score, std::abs(pts[a].mean[k] - pts[b].mean[k])/dab*dist(c, a)/spread[k]);
+        }
+        if (score > best){
+            best = score;
+            pick = c;
+        }
+    }
+    lastScore = best;
+    return (best < precision) ? -1 : static_cast<int>(pick);
+}
+
+// Welford update of mean and sum of squared deviations
+
+void AdaptiveSweep::record(int c, const std::vector<double>& y)
+{
+    auto& p = pts[c];
+    if (p.n == 0){
+        p.mean.assign(y.size(), 0.0);
+        p.m2.assign(y.size(), 0.0);
+    }
+    ++p.n;
+    for (size_t k = 0; k < y.size(); ++k){
+        double d = y[k] - p.mean[k];
+        p.mean[k] += d/p.n;
+        p.m2[k] += d*(y[k] - p.mean[k]);
+    }
+    ++runs;
+}
+
+std::string AdaptiveSweep::report(const std::vector<std::string>& names)
+{
+    std::string out = fmt::format("# adaptive sweep: {} runs, last score {:.3e}, precision {:.3e}\n",
+                                  runs, lastScore, precision);
+    out += fmt::format("{:>6} {:>4}", "runNum", "n");
+    for (auto& s : names) out += fmt::format(" {:>11} {:>11}", s, s + "SE");
+    out += "\n";
+    for (size_t c = 0; c < pts.size(); ++c){
+        auto& p = pts[c];
+        if (p.n == 0) continue;
+        out += fmt::format("{:>6} {:>4}", runNum[c], p.n);
+        for (size_t k = 0; k < p.mean.size(); ++k){
+            double se = (p.n > 1) ? sqrt(p.m2[k]/(p.n - 1)/p.n) : -1.0;
+            out += fmt::format(" {:11.4e} {:11.4e}", p.mean[k], se);
+        }
+        out += "\n";
+    }
+    return out;
+}
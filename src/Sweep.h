@@ -0,0 +1,38 @@
+#ifndef _Sweep_h
+#define _Sweep_h 1
+
+#include <vector>
+#include <string>
+
+#include APPL_H
+
+// Adaptive sampling of the runs of a design. Candidates are the runs of the expanded parm file, each the text of its linesPerRun lines, so design levels and scales come from MakeParam as for a full sweep. Design values, tokens 1..11 after runNum, are coordinates; values on exponential scales are taken as log, then each coordinate is scaled to [0,1]. Coordinates with one level are dropped.
+
+// First a space-filling set: start at the candidate nearest the center, then repeatedly add the candidate farthest from all chosen. Then each step scores, in units of the spread of each output among sampled points:
+//   new point c: slope between its two nearest sampled points times distance to the nearer one, ie, expected change of output not yet seen;
+//   replicate of sampled point i: standard error of its mean, from variance pooled over replicated points.
+// Outputs whose spread is within the noise expected in sampled means are flat and not scored. Run the highest score over all outputs and candidates. Stop when best score < precision, or after budget runs.
+
+class AdaptiveSweep
+{
+public:
+    AdaptiveSweep(const std::vector<std::string>& runLines, double precision, int budget);
+    int         next();                                 // candidate index for next run, -1 when done
+    void        record(int c, const std::vector<double>& y);    // outputs of run of candidate c
+    std::string report(const std::vector<std::string>& names);  // per sampled candidate: runs, means, se
+    double      getLastScore(){return lastScore;}
+private:
+    struct Point {int n = 0; std::vector<double> mean; std::vector<double> m2;};
+    double      dist(size_t a, size_t b);
+    std::vector<std::vector<double>> x;     // scaled coordinates of candidates
+    std::vector<int>    runNum;
+    std::vector<Point>  pts;
+    std::vector<size_t> initial;            // space-filling set, in order
+    size_t      nextInitial = 0;
+    double      precision;
+    int         budget;
+    int         runs = 0;
+    double      lastScore = 0.0;
+};
+
+#endif
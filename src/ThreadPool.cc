@@ -0,0 +1,70 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned n, std::function<void(unsigned)> f) : init(std::move(f))
+{
+    for (unsigned i = 0; i < n; ++i)
+        threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    start.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void ThreadPool::run(size_t rows, const std::function<void(size_t, size_t)>& f)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    job = &f;
+    jobRows = rows;
+    next = 0;
+    active = static_cast<unsigned>(threads.size());
+    ++generation;
+    start.notify_all();
+    finish.wait(lock, [this]{return active == 0;});
+    job = nullptr;
+    if (error){
+        auto e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void ThreadPool::work(unsigned k)
+{
+    unsigned long seen = 0;
+    // failure of init, eg, a cpu outside the process cpuset, is reported by the next run(); worker still works, unpinned
+    try {
+        if (init) init(k);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!error) error = std::current_exception();
+    }
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            start.wait(lock, [&]{return quit || generation != seen;});
+            if (quit) return;
+            seen = generation;
+        }
+        try {
+            size_t first;
+            while ((first = next.fetch_add(block)) < jobRows)
+                (*job)(first, std::min(first + block, jobRows));
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!error) error = std::current_exception();
+            next = jobRows;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--active == 0) finish.notify_one();
+    }
+}
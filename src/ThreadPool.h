@@ -0,0 +1,37 @@
+#ifndef _ThreadPool_h
+#define _ThreadPool_h 1
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+// Persistent workers; run() hands them rows [0, rows) of a job in blocks and returns when all blocks are done. First exception thrown by a worker is rethrown by run(). If given, init(k) runs first on worker k, eg, to pin it to a cpu, see Numa.h; an exception from init is rethrown by the first run().
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned n, std::function<void(unsigned)> init = nullptr);
+    ~ThreadPool();
+    void    run(size_t rows, const std::function<void(size_t, size_t)>& f);
+private:
+    void    work(unsigned k);
+    static constexpr size_t block = 64;
+    std::vector<std::thread>    threads;
+    std::function<void(unsigned)> init;
+    std::mutex                  mtx;
+    std::condition_variable     start;
+    std::condition_variable     finish;
+    const std::function<void(size_t, size_t)> *job = nullptr;
+    size_t                      jobRows = 0;
+    std::atomic<size_t>         next{0};
+    unsigned                    active = 0;
+    unsigned long               generation = 0;
+    bool                        quit = false;
+    std::exception_ptr          error;
+};
+
+#endif
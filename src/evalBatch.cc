@@ -0,0 +1,182 @@
+// Stand alone batch evaluation of J and fitness, linked to lib$(NAME).a, see Evaluate.h. Reads genotypes from stdin, writes J and fitness to stdout in input order. Input is read in chunks; each chunk is split into blocks of rows among a pool of worker threads, then written before the next chunk is read, so memory stays bounded for any input size.
+
+// CSV input: one row per line, loci genotype alleles, then loci stochast alleles if |stochWt| >= 1e-6 as in the simulation, see EvalStoch, separated by commas or white space; blank lines and lines starting with # skipped. Output: J,fitness per line.
+// Binary input (-b): rows of float32 alleles with the same layout. Output: float64 pairs J, fitness per row.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <cstdlib>
+#include <cstring>
+
+#include "fmt/format.h"
+
+#include APPL_H
+#include "Evaluate.h"
+#include "Performance.h"
+#include "ThreadPool.h"
+
+bool showProgress = false;
+
+/********************** Prototypes ****************************/
+
+size_t  ReadCSV(std::istream& in, std::vector<Allele>& buf, size_t width, size_t maxRows, size_t& line);
+size_t  ReadBinary(std::istream& in, std::vector<Allele>& buf, size_t width, size_t maxRows);
+
+/**************************************************************/
+
+int main(int argc, char *argv[])
+{
+    EvalParam p = {Loop::close, 1.0, 0.0, 0.0, false, 0.1, 0.0};
+    int loci = 0;
+    int odeMethod = 0;
+    bool binary = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunk = 1 << 16;
+    unsigned long seed = 0;
+
+    std::string usage =
+        fmt::format("\n\tUSAGE:  {} [-b] [-t threads] [-c rows] [-m odeMethod] -n loci [-l loop] [-g gamma]\n", argv[0])
+        + "\t\t[-a aSD] [-w stochWt] [-f fitVar] [-u ctrlWt] [-k ctrlOrder] [-p plantOrder] [-r seed] < genotypes > results\n\n"
+        + "\t\t-b binary float32 input and float64 output, default CSV\n"
+        + "\t\t-t worker threads, default hardware concurrency\n"
+        + "\t\t-c rows per chunk read from input, default 65536\n"
+        + "\t\t-m step response integration, 0 => native, 1 => GSL\n"
+        + "\t\t-n loci per genotype, as in param loci\n"
+        + "\t\t-l loop type, 0 => open, 1 => close, 2 => dclose, default 1\n"
+        + "\t\t-g gamma, default 1; -a aSD, default 0; -w stochWt, default 0 => no stochast alleles\n"
+        + "\t\t-f fitVar, default 0.1; -u ctrlWt, weight of control signal cost, default 0\n"
+        + "\t\t-k ctrlOrder, -p plantOrder, as in params, default 2, 2\n"
+        + "\t\t-r seed for per row random streams, default 0\n\n";
+    try {
+        for (int arg = 1; arg < argc; ++arg){
+            if (argv[arg][0] != '-' || strlen(argv[arg]) != 2) throw std::exception();
+            char c = argv[arg][1];
+            if (c == 'b'){
+                binary = true;
+                continue;
+            }
+            if (arg + 1 >= argc) throw std::exception();
+            std::string v = argv[++arg];
+            switch (c){
+                case 't': threads = static_cast<unsigned>(std::stoul(v)); break;
+                case 'c': chunk = std::stoul(v); break;
+                case 'm': odeMethod = std::stoi(v); break;
+                case 'n': loci = std::stoi(v); break;
+                case 'l': p.loop = static_cast<Loop>(std::stoi(v)); break;
+                case 'g': p.gamma = std::stod(v); break;
+                case 'a': p.aSD = std::stod(v); break;
+                case 'w': p.stochWt = std::stod(v); break;
+                case 'f': p.fitVar = std::stod(v); break;
+                case 'u': p.ctrlWt = std::stod(v); break;
+                case 'k': p.ctrlOrder = std::stoi(v); break;
+                case 'p': p.plantOrder = std::stoi(v); break;
+                case 'r': seed = std::stoul(v); break;
+                default: throw std::exception();
+            }
+        }
+        if (loci <= 0 || threads == 0 || chunk == 0 || odeMethod < 0 || odeMethod > 1
+            || p.plantOrder < 2 || p.ctrlOrder < p.plantOrder
+            || static_cast<int>(p.loop) < 0 || static_cast<int>(p.loop) > 2)
+            throw std::exception();
+    }
+    catch (const std::exception& e) {
+        std::cerr << usage << std::endl;
+        exit(1);
+    }
+    try {
+        p.stoch = EvalStoch(p.stochWt);
+        setStepMethod(static_cast<stepMethod>(odeMethod));
+        setGSLErrorHandle(1);
+        std::ios::sync_with_stdio(false);
+        auto L = static_cast<size_t>(loci);
+        size_t width = (p.stoch) ? 2*L : L;
+        std::vector<Allele> in, genotypes, stochasts;
+        std::vector<double> J, fitness;
+        ThreadPool pool(threads);
+        size_t done = 0, line = 0;
+        while (true){
+            size_t rows = (binary) ? ReadBinary(std::cin, in, width, chunk) : ReadCSV(std::cin, in, width, chunk, line);
+            if (rows == 0) break;
+            // split interleaved rows into genotype and stochast arrays as used by EvalBatch
+            genotypes.resize(rows*L);
+            if (p.stoch) stochasts.resize(rows*L);
+            for (size_t i = 0; i < rows; ++i){
+                std::copy_n(&in[i*width], L, &genotypes[i*L]);
+                if (p.stoch) std::copy_n(&in[i*width + L], L, &stochasts[i*L]);
+            }
+            J.resize(rows);
+            fitness.resize(rows);
+            // row numbers continue across chunks, so seeds match a single call over all rows
+            pool.run(rows, [&](size_t first, size_t last){
+                EvalBatch(&genotypes[first*L], (p.stoch) ? &stochasts[first*L] : nullptr, loci, last - first,
+                          p, seed, done + first, &J[first], &fitness[first]);
+            });
+            if (binary){
+                std::vector<double> out(2*rows);
+                for (size_t i = 0; i < rows; ++i){
+                    out[2*i] = J[i];
+                    out[2*i+1] = fitness[i];
+                }
+                std::cout.write(reinterpret_cast<const char *>(out.data()),
+                                static_cast<std::streamsize>(out.size()*sizeof(double)));
+            }
+            else{
+                std::string out;
+                for (size_t i = 0; i < rows; ++i)
+                    out += fmt::format("{:.12g},{:.12g}\n", J[i], fitness[i]);
+                std::cout << out;
+            }
+            if (!std::cout)
+                ThrowError(__FILE__, __LINE__, "Error writing results to stdout");
+            done += rows;
+        }
+        std::cout.flush();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        exit(1);
+    }
+    return 0;
+}
+
+size_t ReadCSV(std::istream& in, std::vector<Allele>& buf, size_t width, size_t maxRows, size_t& line)
+{
+    buf.clear();
+    size_t rows = 0;
+    std::string s;
+    while (rows < maxRows && std::getline(in, s)){
+        ++line;
+        auto start = s.find_first_not_of(" \t\r");
+        if (start == std::string::npos || s[start] == '#') continue;
+        const char *c = s.c_str() + start;
+        for (size_t j = 0; j < width; ++j){
+            char *end;
+            float x = strtof(c, &end);
+            if (end == c)
+                ThrowError(__FILE__, __LINE__, fmt::format("Line {}: expected {} values", line, width));
+            buf.push_back(x);
+            c = end;
+            while (*c == ',' || *c == ' ' || *c == '\t' || *c == '\r') ++c;
+        }
+        if (*c != '\0')
+            ThrowError(__FILE__, __LINE__, fmt::format("Line {}: more than {} values", line, width));
+        ++rows;
+    }
+    return rows;
+}
+
+size_t ReadBinary(std::istream& in, std::vector<Allele>& buf, size_t width, size_t maxRows)
+{
+    static_assert(sizeof(Allele) == 4, "binary input is float32");
+    buf.resize(width*maxRows);
+    in.read(reinterpret_cast<char *>(buf.data()), static_cast<std::streamsize>(buf.size()*sizeof(Allele)));
+    auto bytes = static_cast<size_t>(in.gcount());
+    if (bytes % (width*sizeof(Allele)) != 0)
+        ThrowError(__FILE__, __LINE__, "Binary input ends within a row");
+    return bytes / (width*sizeof(Allele));
+}
@@ -4,6 +4,8 @@
 #include <sstream>
 #include <exception>
 #include <cctype>
+#include <map>
+#include <memory>
 
 #include <boost/filesystem.hpp>
 #include <boost/asio/ip/host_name.hpp>
@@ -12,16 +14,33 @@
 
 #include "param.h"
 #include APPL_H
+#include "ResultWriter.h"
+#include "Status.h"
+#include "Sweep.h"
+#include "Paired.h"
+#include "Aggregate.h"
+#include "SumStat.h"
+#include "Memo.h"
+#include "Numa.h"
 
 bool showProgress = false;
 constexpr int maxLinesPerRun = 20;
+const std::string memoFile = "output/memo.bin";       // shared by experiments, see Memo.h
 
 /********************** Prototypes ****************************/
 
-void 		    InitRuns(int& first, int& last, std::fstream& randFile, std::ifstream& paramFile,
-                         std::ofstream& outFile, const std::string& exp);
-void 		    UpdateRandFile(std::fstream& randFile, int first, int last);
-std::string     WriteParmBuf(int first, std::fstream& randFile, std::ifstream& paramFile);
+std::string	    InitRuns(int& first, int& last, std::fstream& randFile, std::ifstream& paramFile,
+                         const std::string& exp, bool compress);
+rndType         ReadSeed(std::fstream& randFile);
+void 		    UpdateRandFile(std::fstream& randFile, int first, int last, rndType seed);
+std::string     WriteParmBuf(int first, rndType seed, std::ifstream& paramFile);
+std::string     ReadRunLines(std::ifstream& paramFile);
+void            AdaptiveRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                             ResultWriter& writer, int budget, double precision);
+void            PairedLoopRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                               ResultWriter& writer);
+void            AggregateRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                              ResultWriter& writer, double target);
 
 /**************************************************************/
 
@@ -29,23 +48,55 @@ int main(int argc, char *argv[])
 {
 	int i, first, last, arg;
     std::string exp;
+    bool compress = false;
+    int syncEvery = 0;
+    int budget = 0;
+    double precision = 0.05;
+    bool paired = false;
+    bool aggregate = false;
+    double target = 0.0;
+    bool memoOn = false;
+    int numaCpu = -1;
+    bool huge = false;
 
     std::string usage =
-        fmt::format("\n\tUSAGE:  {} -s experiment\n\n", argv[0])
-        + "\t\t-s to show progress on stdout\n\n"
+        fmt::format("\n\tUSAGE:  {} [-s] [-z] [-y n] [-n cpu [-l]] [-a n [-p x] | -c | -r [-e x] | -m] experiment\n\n", argv[0])
+        + "\t\t-s to show progress on stdout\n"
+        + "\t\t-z to write output as bzip2 compressed data.Exp*.bz2\n"
+        + "\t\t-y n to fsync output after every n runs, default 0 => never\n"
+        + "\t\t-n cpu to pin to cpu, memory on its NUMA node, Linux only, see Numa.h; -l for huge pages\n"
+        + "\t\t-a n for adaptive sampling of design runs, at most n runs, see Sweep.h\n"
+        + "\t\t-p x adaptive stops when best score < x, in units of output spread, default 0.05\n"
+        + "\t\t-c to pair runs across loop types with common random numbers, see Paired.h\n"
+        + "\t\t-r to write one summary per design point for its replicates, see Aggregate.h\n"
+        + "\t\t-e x with -r, stop replicates when 95% half width of mean aveFitness <= x\n"
+        + "\t\t-m to reuse results of earlier runs with the same parameters and seed, see Memo.h\n\n"
         + "\t\texperiment must begin with a letter\n\n";
     try {
         if (argc == 1) throw std::exception();
-        // if '-' switch, assume -s and set arg = 2 to expect second arg
-        if (argv[1][0] == '-'){
-            showProgress = true;
-            arg = 2;
+        // switches before experiment, single letter each, may be combined as in -sz
+        for (arg = 1; arg < argc && argv[arg][0] == '-'; ++arg){
+            for (char *c = argv[arg] + 1; *c; ++c){
+                if (*c == 's') showProgress = true;
+                else if (*c == 'z') compress = true;
+                else if (*c == 'y' && arg + 1 < argc) syncEvery = std::stoi(argv[++arg]);
+                else if (*c == 'a' && arg + 1 < argc) budget = std::stoi(argv[++arg]);
+                else if (*c == 'p' && arg + 1 < argc) precision = std::stod(argv[++arg]);
+                else if (*c == 'c') paired = true;
+                else if (*c == 'r') aggregate = true;
+                else if (*c == 'e' && arg + 1 < argc) target = std::stod(argv[++arg]);
+                else if (*c == 'm') memoOn = true;
+                else if (*c == 'n' && arg + 1 < argc) numaCpu = std::stoi(argv[++arg]);
+                else if (*c == 'l') huge = true;
+                else throw std::exception();
+            }
         }
         // expect one arg, which is experiment letter
-        else arg = 1;
         if (arg < argc && std::isalpha(argv[arg][0]))
             exp = argv[arg];
         else throw std::exception();
+        if ((budget > 0) + paired + aggregate + memoOn > 1 || (target > 0.0 && !aggregate) || (huge && numaCpu < 0))
+            throw std::exception();
     }
     catch (const std::exception& e) {
         std::cerr << usage << std::endl;
@@ -54,20 +105,53 @@ int main(int argc, char *argv[])
     try {
         if (linesPerRun > maxLinesPerRun)
             ThrowError(__FILE__, __LINE__, "LinesPerRun greater than maxLinesPerRun.");
+        if (numaCpu >= 0) NumaSetup(numaCpu, huge);     // before populations are allocated
         MakeParam("input/", "design", exp.c_str(), 2);
         std::ifstream paramFile;
         std::fstream randFile;
-        std::ofstream outFile;
         std::istringstream parmBuf;
-        InitRuns(first, last, randFile, paramFile, outFile, exp);
-        for (i = first; i <= last; ++i){
-            parmBuf.clear();        // must reset before reloading
-            parmBuf.str(WriteParmBuf(i, randFile, paramFile));
-            std::string result = Control(parmBuf);
-            outFile << result;
-            outFile.flush();
-            UpdateRandFile(randFile, i+1, last);
+        auto outName = InitRuns(first, last, randFile, paramFile, exp, compress);
+        // after this point, only the writer thread touches randFile, seed for each run kept here
+        rndType seed = ReadSeed(randFile);
+        ResultWriter writer(outName, compress, syncEvery);
+        status.open(outputTag, first, (budget > 0) ? first + budget - 1 : last);
+        if (budget > 0)
+            AdaptiveRuns(first, last, seed, randFile, paramFile, writer, budget, precision);
+        else if (paired)
+            PairedLoopRuns(first, last, seed, randFile, paramFile, writer);
+        else if (aggregate)
+            AggregateRuns(first, last, seed, randFile, paramFile, writer, target);
+        else{
+            std::unique_ptr<ResultMemo> memo;
+            if (memoOn) memo = std::make_unique<ResultMemo>(memoFile);
+            for (i = first; i <= last; ++i){
+                parmBuf.clear();        // must reset before reloading
+                parmBuf.str(WriteParmBuf(i, seed, paramFile));
+                std::string result, key;
+                int runNum = 0;
+                if (memo){
+                    std::istringstream keyBuf(parmBuf.str());
+                    key = RunKey(keyBuf, runNum);
+                }
+                if (!key.empty() && memo->find(key, result, seed)){
+                    // first line of result is runNum, see PrintParam
+                    result.replace(0, result.find('\n'), fmt::format("{:<10} = {:>9}", "Run", runNum));
+                }
+                else{
+                    result = Control(parmBuf);
+                    seed = rnd.rawint();
+                    if (!key.empty()) memo->insert(key, result, seed);
+                }
+                status.phase(StatusData::write);     // push blocks only if writer falls behind
+                writer.push(std::move(result), [&randFile, i, last, seed]{UpdateRandFile(randFile, i+1, last, seed);});
+            }
+            if (memo && showProgress)
+                std::cout << fmt::format("Memo: {} of {} runs found, {} records\n", memo->getHits(), last - first + 1,
+                                         memo->getRecords());
         }
+        CloseDumps();
+        writer.close();
+        status.close();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -77,7 +161,7 @@ int main(int argc, char *argv[])
 	return 0;
 }
 
-std::string WriteParmBuf(int first, std::fstream& randFile, std::ifstream& paramFile)
+rndType ReadSeed(std::fstream& randFile)
 {
     randFile.seekg(0);
     std::string tmp;
@@ -85,18 +169,135 @@ std::string WriteParmBuf(int first, std::fstream& randFile, std::ifstream& param
     for (unsigned i = 0; i < 11; ++i) randFile >> tmp;
     // be careful if rndType is 32 bit and seed in file is 64 bit
     randFile >> seed;
+    return seed;
+}
+
+std::string WriteParmBuf(int first, rndType seed, std::ifstream& paramFile)
+{
+    std::string parmBuf = fmt::format("{} {} {} {}", first, first, seed, ReadRunLines(paramFile));
+    return parmBuf;
+}
+
+std::string ReadRunLines(std::ifstream& paramFile)
+{
     std::string buf;
 	for (int i = 0; i < linesPerRun; ++i){
         std::string lineBuf;
         std::getline(paramFile,lineBuf);
         buf += lineBuf;
 	}
-    std::string parmBuf = fmt::format("{} {} {} {}", first, first, seed, buf);
-    return parmBuf;
+    return buf;
 }
 
-void InitRuns(int& first, int& last, std::fstream& randFile, std::ifstream& paramFile,
-              std::ofstream& outFile, const std::string& exp)
+// Runs first..last of parm file are candidates, chosen by AdaptiveSweep, with replicates as separate results with the same runNum. Sampling depends on results, so there is no restart: ledger keeps first run and only advances the seed. Means and standard errors of outputs per sampled run go to output/adaptive.<tag>.txt.
+
+void AdaptiveRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                  ResultWriter& writer, int budget, double precision)
+{
+    std::vector<std::string> runLines;
+    for (int i = first; i <= last; ++i)
+        runLines.push_back(ReadRunLines(paramFile));
+    if (!paramFile)
+        ThrowError(__FILE__, __LINE__, "Error reading candidate runs from parm file");
+    AdaptiveSweep sweep(runLines, precision, budget);
+    std::istringstream parmBuf;
+    int c;
+    while ((c = sweep.next()) >= 0){
+        parmBuf.clear();
+        parmBuf.str(fmt::format("{} {} {} {}", first + c, first + c, seed, runLines[c]));
+        std::string result = Control(parmBuf);
+        auto s = LastRunSummary();
+        sweep.record(c, {s.aveFitness, s.gSD, s.lowFitRepeat});
+        seed = rnd.rawint();
+        status.phase(StatusData::write);
+        writer.push(std::move(result), [&randFile, first, last, seed]{UpdateRandFile(randFile, first, last, seed);});
+    }
+    std::string filename = fmt::format("output/adaptive.{}.txt", outputTag);
+    std::ofstream out(filename);
+    out << sweep.report({"aveFit", "gSD", "lowFitRep"});
+    if (!out)
+        ThrowError(__FILE__, __LINE__, "Error writing " + filename);
+}
+
+// Runs first..last in order, each replicate of a design point with one seed for all loop types, see Paired.h. Seed advances only when a run takes a new seed, so later replicates never reuse a seed. Paired differences of outputs go to output/paired.<tag>.txt.
+
+void PairedLoopRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                    ResultWriter& writer)
+{
+    PairedRuns pairs;
+    std::istringstream parmBuf;
+    pairedStreams = true;
+    for (int i = first; i <= last; ++i){
+        auto runLine = ReadRunLines(paramFile);
+        auto runSeed = pairs.seed(runLine, seed);
+        parmBuf.clear();
+        parmBuf.str(fmt::format("{} {} {} {}", i, i, runSeed, runLine));
+        std::string result = Control(parmBuf);
+        auto s = LastRunSummary();
+        pairs.record({s.aveFitness, s.gSD, s.lowFitRepeat});
+        if (runSeed == seed) seed = rnd.rawint();
+        status.phase(StatusData::write);
+        writer.push(std::move(result), [&randFile, i, last, seed]{UpdateRandFile(randFile, i+1, last, seed);});
+    }
+    std::string filename = fmt::format("output/paired.{}.txt", outputTag);
+    std::ofstream out(filename);
+    out << pairs.report({"aveFit", "gSD", "lowFitRep"});
+    if (!out)
+        ThrowError(__FILE__, __LINE__, "Error writing " + filename);
+}
+
+// Runs first..last in order with replicates aggregated, see Aggregate.h. Lines are read first to count replicates of each design point in the range. Skipped runs and runs whose point is not finished write nothing, but advance the ledger as usual, so a restart loses the partial aggregates of unfinished points.
+
+void AggregateRuns(int first, int last, rndType seed, std::fstream& randFile, std::ifstream& paramFile,
+                   ResultWriter& writer, double target)
+{
+    const int minReps = 3;          // before early stop
+    struct Point {Aggregate agg; int total = 0; bool closed = false; Param param; SumStat stats; std::vector<int> runs;};
+    std::vector<std::string> runLines, keys;
+    std::map<std::string, Point> points;
+    for (int i = first; i <= last; ++i){
+        runLines.push_back(ReadRunLines(paramFile));
+        auto& line = runLines.back();
+        auto start = line.find_first_not_of(" \t");
+        auto pos = (start == std::string::npos) ? std::string::npos : line.find_first_of(" \t", start);
+        keys.push_back((pos == std::string::npos) ? "" : line.substr(pos));
+        ++points[keys.back()].total;
+    }
+    if (!paramFile)
+        ThrowError(__FILE__, __LINE__, "Error reading runs from parm file");
+    std::istringstream parmBuf;
+    for (int i = first; i <= last; ++i){
+        auto& pt = points[keys[i - first]];
+        std::string result;
+        if (!pt.closed){
+            parmBuf.clear();
+            parmBuf.str(fmt::format("{} {} {} {}", i, i, seed, runLines[i - first]));
+            Control(parmBuf);
+            seed = rnd.rawint();
+            if (pt.runs.empty()){
+                pt.param = LastRunParam();
+                pt.stats = LastRunStats();      // shape of fields for fromVector
+            }
+            pt.runs.push_back(i);
+            pt.agg.add(LastRunStats().toVector());
+            int n = pt.agg.getN();
+            bool stop = (target > 0.0 && n >= minReps && pt.agg.halfWidth(0) <= target);    // field 0 is aveFitness
+            if (n == pt.total || stop){
+                SumStat mean = pt.stats, var = pt.stats, half = pt.stats;
+                mean.fromVector(pt.agg.getMean());
+                var.fromVector(pt.agg.variances());
+                half.fromVector(pt.agg.halfWidths());
+                result = PrintAggregate(pt.param, mean, var, half, n, pt.runs);
+                pt.closed = true;
+            }
+        }
+        status.phase(StatusData::write);
+        writer.push(std::move(result), [&randFile, i, last, seed]{UpdateRandFile(randFile, i+1, last, seed);});
+    }
+}
+
+std::string InitRuns(int& first, int& last, std::fstream& randFile, std::ifstream& paramFile,
+                     const std::string& exp, bool compress)
 {
     auto hostname_fqdn = boost::asio::ip::host_name();
     auto hostname_short = hostname_fqdn.substr(0,hostname_fqdn.find_first_of('.'));
@@ -119,21 +320,26 @@ void InitRuns(int& first, int& last, std::fstream& randFile, std::ifstream& para
 	paramFile.open(filename2);
     for (int i = 0; i < linesPerRun * first; ++i)
         std::getline(paramFile,tmp);
-    filename = fmt::format("output/data.Exp{}.{}", exp, hostname_short);
+    outputTag = fmt::format("Exp{}.{}", exp, hostname_short);
+    filename = fmt::format("output/data.Exp{}.{}{}", exp, hostname_short, (compress) ? ".bz2" : "");
     if (boost::filesystem::exists(filename)) {
         filename2 = fmt::format("{}.bak", filename);
         boost::filesystem::rename(filename, filename2);
     }
-	outFile.open(filename);
+    return filename;
 }
 
-void UpdateRandFile(std::fstream& randFile, int first, int last)
+// called on writer thread after result for run first-1 is written
+
+void UpdateRandFile(std::fstream& randFile, int first, int last, rndType seed)
 {
     randFile.seekp(0);
     randFile << fmt::format("Current run = {}\n", first);
     randFile << fmt::format("Last run    = {}\n", last);
-    randFile << fmt::format("Rand seed   = {}\n{:20}", rnd.rawint(), "");
+    randFile << fmt::format("Rand seed   = {}\n{:20}", seed, "");
     randFile.flush();
+    if (!randFile)
+        ThrowError(__FILE__, __LINE__, "Error writing random file");
 }
 
 
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <iostream>
 #include <climits>
+#include <numeric>
+#include <memory>
+#include <map>
 
 #include APPL_H
 #include "fmt/format.h"
@@ -11,19 +14,49 @@
 #include "SAFtimer.h"
 
 #include "Population.h"
+#include "ClonePopulation.h"
+#include "Robustness.h"
+#include "FreqResponse.h"
+#include "StepBands.h"
+#include "Gradient.h"
 #include "Performance.h"
+#include "Evaluate.h"
+#include "Status.h"
+#include "Equilibrium.h"
+#include "Memo.h"
+#include "Numa.h"
+#include "PopDump.h"
 
 const int 	linesPerRun = 3;
+const int   fidCheckEvery = 100;    // generations between checks of coarse fidelity, see LifeCycle
 SAFrand_pcg<pcgT> rnd;
+std::string outputTag;
+bool pairedStreams = false;
+RndStreams rndStreams = {&rnd, &rnd, &rnd};
+SAFrand_pcg<pcgT> rndSelect, rndVary, rndPerturb;     // used when pairedStreams
+
+// Shared burn in: population after burnIn generations of first run in a group, see BurnInKey
+std::string burnInKey;
+std::vector<Individual> burnInPop;
+RunSummary lastSummary;
+SumStat lastStats;
+Param lastParam;
+std::unique_ptr<PopDumpWriter> dumpWriter;     // started by first run with dump, closed by CloseDumps
+std::map<int, int> dumpsOfRun;                  // dumps written per runNum, adaptive sampling repeats runNum for replicates
 
 // start with result and fix all other strings and files
 
 /*************************** prototypes **************************/
 
 void 		GetParam(Param& p, std::istringstream& parmBuf);
+template <typename T>
+void        GetOptParam(T& x, T dflt, std::istringstream& parmBuf);
 void 		LifeCycle(Param& param, std::ostringstream& resultss);
 std::string PrintParam(Param& p);
+std::string PrintRunInfo(Param& p, SumStat& stats);
+std::string BurnInKey(Param& p);
 void        PrintSummary(Param& param, std::ostringstream& resultss, SumStat& stats);
+void        PrintStats(Param& param, std::ostringstream& resultss, SumStat& stats);
 
 /*****************************************************************/
 
@@ -57,35 +90,224 @@ std::string Control(std::istringstream& parmBuf)
 	return resultss.str();
 }
 
+void CloseDumps()
+{
+    if (!dumpWriter) return;
+    auto w = std::move(dumpWriter);
+    w->close();
+}
+
 void LifeCycle(Param& param, std::ostringstream& resultss)
 {
     if (showProgress){
         std::cout << fmt::format("\nrunNum = {:>3}\n\n", param.runNum);
         std::cout.flush();
     }
-    Population p1(param);
-    Population p2(param);
+    setStepMethod(static_cast<stepMethod>(param.odeMethod));
+    if (pairedStreams){
+        rndSelect.setRandSeed(static_cast<rndType>(RowSeed(param.rndSeed, 1)));
+        rndVary.setRandSeed(static_cast<rndType>(RowSeed(param.rndSeed, 2)));
+        rndPerturb.setRandSeed(static_cast<rndType>(RowSeed(param.rndSeed, 3)));
+        rndStreams = {&rndSelect, &rndVary, &rndPerturb};
+    }
+    else
+        rndStreams = {&rnd, &rnd, &rnd};
+    status.startRun(param.runNum, param.gen);
+    setFidelity(fullFidelity);      // J table and initial fitness at full fidelity
+    Individual::setParam(param);
+    Individual::setJTable(param);
+    Individual::setSurrogate(param);
+    int gen = param.gen;
+    int i, start = 0;
+    // generations before coarseGen evaluate fitness at coarse fidelity
+    int coarseGen = (param.fullGen > 0) ? std::max(0, gen - param.fullGen) : 0;
+    Fidelity coarse = scaledFidelity(param.fidScale);
+    bool coarseOn = false;
+    param.fidChange = 0.0;
+    param.fidFail = -1;
+    param.forked = false;
+    // gen may be a design factor: a run not longer than burnIn is an ordinary run that neither forks nor sets the shared population
+    bool share = (param.burnIn > 0 && param.burnIn < gen);
+    if (share){
+        auto key = BurnInKey(param);
+        if (key == burnInKey && !burnInPop.empty()){
+            param.forked = true;
+            start = param.burnIn;
+        }
+        else{
+            burnInKey = key;
+            burnInPop.clear();
+        }
+    }
+    Population p1(param, !param.forked);
+    Population p2(param, !param.forked);
     Population *op, *np, *swap;     // oldpop and newpop
+    std::vector<std::pair<const void *, size_t>> ranges;
+    if (NumaOn()){
+        p1.memoryRanges(ranges);
+        p2.memoryRanges(ranges);
+        for (auto& r : ranges) NumaAdvise(r.first, r.second);
+        NumaAdviseHeap();
+    }
     op = &p1;
     np = &p2;
+    if (param.forked){
+        // copy of shared population is parent population of first generation, which is then overwritten
+        op->setIndividuals(burnInPop);
+        op->recalcFitness();
+    }
     SumStat stats;
     stats.initialize(param);
-    int gen = param.gen;
-    int i;
+
+    Genealogy geneal;
+    Individual::setLogMutations(param.geneal > 0);
+    if (param.geneal > 0){
+        geneal.initialize(param.loci, param.geneal);
+        p1.setGenealogy(&geneal);
+        p2.setGenealogy(&geneal);
+        geneal.setTime(start);      // forked run: founders are the shared population at burnIn
+        op->recordFounders();
+    }
 
     op->setFitnessArray();
-    for (i = 0; i < gen; ++i){
+    // clone classes need fitness that depends only on genotype
+    param.cloneOn = (param.clones > 0 && !param.stoch && std::abs(param.aSD) <= 1e-6 && param.geneal == 0
+                     && param.polyLoci == 1);
+    param.cloneMax = 0;
+    param.cloneMean = 0.0;
+    ClonePopulation cp(param);
+    if (param.cloneOn) cp.compress(*op);
+    status.phase(StatusData::evolve);
+    auto& jTable = Individual::getJTable();
+    Equilibrium eq(param.eqWindow, param.eqTol);
+    param.eqGen = -1;
+    param.degenGen = -1;
+    for (i = start; i < gen; ++i){
         if (showProgress && ((i % 100) == 0))
             std::cout << fmt::format("Rep {:8} of {:8}\n", i, param.gen);
-        np->reproduceMutateCalcFit(*op);
-        swap = op;
-        op = np;
-        np = swap;
+        if (i < coarseGen && (i - start) % fidCheckEvery == 0){
+            double change = (param.cloneOn) ? cp.fidelityChange(coarse, fullFidelity)
+                : op->fidelityChange(coarse, fullFidelity, param.rndSeed + static_cast<ulong>(i));
+            param.fidChange = std::max(param.fidChange, change);
+            if (change > param.fidTol){
+                param.fidFail = i;
+                coarseGen = i;
+            }
+        }
+        if (i < coarseGen && !coarseOn){
+            setFidelity(coarse);
+            coarseOn = true;
+            Individual::getSurrogate().reset();
+            if (param.cloneOn) cp.clearFitness();
+        }
+        else if (i >= coarseGen && coarseOn){
+            // parents selected at full fidelity from here on
+            setFidelity(fullFidelity);
+            coarseOn = false;
+            Individual::getSurrogate().reset();
+            if (param.cloneOn) cp.recalcFitness(); else op->recalcFitness();
+        }
+        if (param.cloneOn){
+            cp.reproduce();
+            auto classes = static_cast<int>(cp.getClasses());
+            param.cloneMax = std::max(param.cloneMax, classes);
+            param.cloneMean += classes;
+            if (share && i + 1 == param.burnIn && !param.forked){
+                cp.expand(*op);
+                burnInPop = op->getIndividuals();
+            }
+            status.generation(i+1, Individual::takeExactEvals());
+        }
+        else{
+            geneal.setTime(i+1);
+            np->reproduceMutateCalcFit(*op);
+            swap = op;
+            op = np;
+            np = swap;
+            if (param.geneal > 0 && geneal.simplifyDue()) op->simplifyGenealogy();
+            if (share && i + 1 == param.burnIn && !param.forked) burnInPop = op->getIndividuals();
+            status.generation(i+1, Individual::takeExactEvals());
+        }
+        if (jTable.isOn()) status.table(jTable.getLookups(), jTable.getMisses());
+        // stop at degenerate fitness or, if monitored, stationary statistics, see Equilibrium.h; monitor only at full fidelity and after shared burn in, so forked runs and the final full fidelity generations are kept
+        bool monitor = (param.eqWindow > 0 && i >= coarseGen && (!share || i + 1 >= param.burnIn));
+        GenStats gs = (param.cloneOn) ? cp.genStats(monitor) : op->genStats(monitor);
+        if (Equilibrium::degenerate(gs)){
+            param.degenGen = i + 1;
+            gen = i + 1;
+            break;
+        }
+        if (monitor && eq.add(gs)){
+            param.eqGen = i + 1;
+            gen = i + 1;
+            break;
+        }
+    }
+    if (param.cloneOn){
+        cp.expand(*op);
+        if (gen > start) param.cloneMean /= gen - start;
     }
+    status.phase(StatusData::stats);
     // run round of selection without mutation or recombination before collecting stats
+    geneal.setTime(gen+1);
     np->reproduceNoMutRec(*op);
-    np->calcStats(param, stats);
+    if (param.geneal > 0){
+        np->simplifyGenealogy();
+        stats.setGenealogy(geneal.getNodes(), geneal.getEdges(), geneal.getMutations(), geneal.tmrca());
+        geneal.write(fmt::format("output/geneal.{}Run{}.txt",
+                                 (outputTag.empty()) ? "" : outputTag + ".", param.runNum));
+    }
+    param.numaNode = NumaNode();
+    if (NumaOn()){
+        // placement of both populations at end of run, see Numa.h
+        ranges.clear();
+        p1.memoryRanges(ranges);
+        p2.memoryRanges(ranges);
+        auto n = NumaCount(ranges);
+        param.numaPages = n.pages;
+        param.numaRemote = n.remote;
+        param.numaHugeKB = n.hugeKB;
+    }
+    PopColumns columns;
+    np->calcStats(param, stats, (param.dump > 0) ? &columns : nullptr);
+    if (param.dump > 0){
+        if (!dumpWriter) dumpWriter = std::make_unique<PopDumpWriter>();
+        DumpHeader h{};
+        h.runNum = param.runNum;
+        h.loci = param.loci;
+        h.gen = gen;
+        h.stoch = param.stoch;
+        h.rndSeed = static_cast<uint64_t>(param.rndSeed);
+        int rep = dumpsOfRun[param.runNum]++;
+        dumpWriter->push(fmt::format("output/pop.{}Run{}{}.bin", (outputTag.empty()) ? "" : outputTag + ".", param.runNum,
+                                     (rep > 0) ? fmt::format(".rep{}", rep) : ""), h, std::move(columns));
+    }
     PrintSummary(param, resultss, stats);
+    if (param.robust > 0) resultss << RobustnessScan(*np, param);
+    if (param.freqResp > 0) resultss << FreqResponse(*np, param);
+    if (param.stepBands > 0) resultss << StepBands(*np, param);
+    if (param.selGrad > 0) resultss << SelectionGradient(*np, param);
+    auto& gSD = stats.getGSD();
+    lastSummary = {stats.getAveFitness(), std::accumulate(gSD.begin(), gSD.end(), 0.0)/static_cast<double>(gSD.size()),
+                   stats.getLowFitRepeat()};
+    lastStats = stats;
+    lastParam = param;
+    status.endRun();
+}
+
+RunSummary LastRunSummary()
+{
+    return lastSummary;
+}
+
+SumStat& LastRunStats()
+{
+    return lastStats;
+}
+
+Param& LastRunParam()
+{
+    return lastParam;
 }
 
 void GetParam(Param& p, std::istringstream& parmBuf)
@@ -98,19 +320,56 @@ void GetParam(Param& p, std::istringstream& parmBuf)
         ThrowError(__FILE__, __LINE__, "Failed reading from parameter string stream.");
 
     p.loop = static_cast<Loop>(round<int>(tmpLoop));
-    p.loci = (p.loop == Loop::dclose) ? 7 : 5;
     p.gen = round<int>(tmpGen);
     p.popsize = round<int>(tmpPop);
-    p.stoch = (abs(p.stochWt) < 1e-6) ? false : true;
+    p.stoch = EvalStoch(p.stochWt);
     p.mutLocus = round<int>(tmpMutLoc);
-    if (p.mutLocus >= p.loci)
-        ThrowError(__FILE__, __LINE__, "Mutated locus number greater than number loci.");
 
     int newseed;
     unsigned long seed;
     parmBuf >> p.distnSteps >> seed >> newseed;
     if (parmBuf.bad())
         ThrowError(__FILE__, __LINE__, "Failed reading from parameter string stream.");
+    GetOptParam(p.tableErr, 0.0, parmBuf);
+    GetOptParam(p.odeMethod, 0, parmBuf);
+    if (p.odeMethod < 0 || p.odeMethod > 2)
+        ThrowError(__FILE__, __LINE__, "odeMethod must be 0, 1 or 2.");
+    GetOptParam(p.geneal, 0, parmBuf);
+    GetOptParam(p.burnIn, 0, parmBuf);
+    GetOptParam(p.ctrlWt, 0.0, parmBuf);
+    if (p.ctrlWt < 0.0)
+        ThrowError(__FILE__, __LINE__, "ctrlWt must be >= 0.");
+    GetOptParam(p.fullGen, 0, parmBuf);
+    GetOptParam(p.fidScale, 100.0, parmBuf);
+    GetOptParam(p.fidTol, 0.01, parmBuf);
+    GetOptParam(p.clones, 0, parmBuf);
+    GetOptParam(p.surrTol, 0.0, parmBuf);
+    GetOptParam(p.robust, 0, parmBuf);
+    if (p.robust > 0 && p.odeMethod == 2)
+        ThrowError(__FILE__, __LINE__, "robust uses batch evaluation, which needs odeMethod 0 or 1.");
+    GetOptParam(p.freqResp, 0, parmBuf);
+    GetOptParam(p.stepBands, 0, parmBuf);
+    GetOptParam(p.ctrlOrder, 2, parmBuf);
+    GetOptParam(p.plantOrder, 2, parmBuf);
+    GetOptParam(p.eqWindow, 0, parmBuf);
+    GetOptParam(p.eqTol, 0.1, parmBuf);
+    if (p.eqWindow < 0 || (p.eqWindow > 0 && p.eqWindow < 10) || p.eqTol < 0.0)
+        ThrowError(__FILE__, __LINE__, "eqWindow must be 0 or >= 10, eqTol >= 0.");
+    GetOptParam(p.selGrad, 0, parmBuf);
+    GetOptParam(p.dump, 0, parmBuf);
+    GetOptParam(p.polyLoci, 1, parmBuf);
+    if (p.polyLoci < 1 || (p.polyLoci > 1 && (p.stoch || p.geneal > 0)))
+        ThrowError(__FILE__, __LINE__, "polyLoci must be >= 1, and 1 with stochWt or geneal.");
+    EvalParam ep = {p.loop, p.gamma, p.aSD, p.stochWt, p.stoch, p.fitVar, p.ctrlWt, p.ctrlOrder, p.plantOrder};
+    int dim = EvalStateDim(ep);
+    if (p.plantOrder < 2 || p.ctrlOrder < p.plantOrder || dim > maxStepDim)
+        ThrowError(__FILE__, __LINE__, fmt::format("Need 2 <= plantOrder <= ctrlOrder and state dimension {} <= {}.",
+                                                   dim, maxStepDim));
+    if ((p.ctrlOrder != 2 || p.plantOrder != 2) && !Individual::initialOrderStable(ep, rnd))
+        ThrowError(__FILE__, __LINE__, "Initial genotype unstable for these orders, loop and gamma, see initialGenotypeOrder.");
+    p.loci = EvalLoci(p.loop, p.ctrlOrder);
+    if (p.mutLocus >= p.loci)
+        ThrowError(__FILE__, __LINE__, "Mutated locus number greater than number loci.");
     
     // seed may be 64bit, but rndType may be 32 bit, if so, truncate seed
     if (!newseed){
@@ -123,6 +382,39 @@ void GetParam(Param& p, std::istringstream& parmBuf)
     }
 }
 
+// Key for ResultMemo, see Memo.h; parmBuf as for Control. GetParam may seed rnd, which Control seeds again before a run. Runs that fork from a shared burn in depend on an earlier run, runs with genealogy or population dump write their own files, and runs with NUMA placement, -n, report page placement measured in this process, see Numa.h, so none of these is memoized.
+
+std::string RunKey(std::istringstream& parmBuf, int& runNum)
+{
+    Param p;
+    int first, last;
+    parmBuf >> first >> last >> p.rndSeed;
+    if (parmBuf.bad())
+        ThrowError(__FILE__, __LINE__, "Failed reading from parameter string stream.");
+    if (sizeof(rndType) != sizeof(unsigned long)) p.rndSeed = static_cast<rndType>(p.rndSeed);
+    GetParam(p, parmBuf);
+    runNum = p.runNum;
+    if (p.geneal > 0 || p.burnIn > 0 || p.dump > 0 || NumaOn()) return "";
+    return fmt::format("{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}",
+                       static_cast<int>(p.loop), p.gen, p.popsize, p.mutation, p.recombination, p.mutStep, p.aSD,
+                       p.fitVar, p.gamma, p.stochWt, p.mutLocus, p.distnSteps, p.rndSeed, p.tableErr, p.odeMethod,
+                       p.ctrlWt, p.fullGen, p.fidScale, p.fidTol, p.clones, p.surrTol, p.robust, p.freqResp,
+                       p.stepBands, p.ctrlOrder, p.plantOrder, p.eqWindow, p.eqTol, p.selGrad,
+                       p.polyLoci);
+}
+
+// Control parameters added after newseed are optional, so that older design files still run. If a value is missing, use default; values must be given in order, so once one is missing, all later ones take defaults.
+
+template <typename T>
+void GetOptParam(T& x, T dflt, std::istringstream& parmBuf)
+{
+    if (!(parmBuf >> x)){
+        if (parmBuf.bad())
+            ThrowError(__FILE__, __LINE__, "Failed reading from parameter string stream.");
+        x = dflt;
+    }
+}
+
 std::string PrintParam(Param& p)
 {
     std::string outString;
@@ -144,7 +436,46 @@ std::string PrintParam(Param& p)
     outString += fmt::format(formatf, "gamma", p.gamma);
     outString += fmt::format(formatf, "stochWt", p.stochWt);
     outString += fmt::format(format,  "mutLocus", p.mutLocus);
-    outString += "\n";
+    auto& jTable = Individual::getJTable();
+    if (jTable.isOn()){
+        outString += fmt::format(formatf, "tableErr", p.tableErr);
+        outString += fmt::format(format,  "tblNodes", jTable.getNodes());
+        outString += fmt::format(format,  "tblMiss", jTable.getMisses());
+        outString += fmt::format(formatf, "tblSpotE", jTable.getMaxSpotErr());
+    }
+    auto& surrogate = Individual::getSurrogate();
+    if (surrogate.isOn()){
+        outString += fmt::format(formatf, "surrTol", p.surrTol);
+        outString += fmt::format(format,  "surrCalls", surrogate.getLookups());
+        outString += fmt::format(format,  "surrExact", surrogate.getExact());
+        outString += fmt::format(format,  "surrAudit", surrogate.getAudits());
+        outString += fmt::format(formatf, "surrMaxE", surrogate.getMaxAuditErr());
+        outString += fmt::format(formatf, "surrRmsE", surrogate.getRmsAuditErr());
+        outString += fmt::format(format,  "surrOff", static_cast<int>(surrogate.getSuspended()));
+    }
+    if (p.ctrlOrder != 2 || p.plantOrder != 2){
+        outString += fmt::format(format,  "ctrlOrder", p.ctrlOrder);
+        outString += fmt::format(format,  "plantOrder", p.plantOrder);
+    }
+    if (p.polyLoci != 1)
+        outString += fmt::format(format,  "polyLoci", p.polyLoci);
+    if (p.ctrlWt != 0.0)
+        outString += fmt::format(formatf, "ctrlWt", p.ctrlWt);
+    if (p.fullGen > 0){
+        outString += fmt::format(format,  "fullGen", p.fullGen);
+        outString += fmt::format(formatf, "fidScale", p.fidScale);
+        outString += fmt::format(formatf, "fidTol", p.fidTol);
+    }
+    if (p.odeMethod != 0)
+        outString += fmt::format(format,  "odeMeth", p.odeMethod);
+    if (getStepMethod() == stepMethod::parity){
+        auto parity = getStepParity();
+        outString += fmt::format(format,  "odeCount", parity.count);
+        outString += fmt::format(formatf, "odeAbsD", parity.maxAbs);
+        outString += fmt::format(formatf, "odeRelD", parity.maxRel);
+    }
+    if (getStepFailures() > 0)
+        outString += fmt::format(format,  "odeFail", getStepFailures());
     return outString;
 }
 
@@ -200,9 +531,95 @@ void PrintGCorr(Param& param, std::ostringstream& resultss, std::vector<std::vec
     resultss << "\n\n";
 }
 
+// Runs with same key share burn in. Excludes aSD and stochWt, which only change fitness of a given genotype, and gen, seed and run number except through the coarse fidelity schedule, but includes whether stochast alleles exist. Clone classes have the same distribution as individuals, so clones is excluded. Runs in a group need not be consecutive, but the snapshot is replaced whenever the key changes.
+
+std::string BurnInKey(Param& p)
+{
+    // generations of burn in at coarse fidelity
+    int coarseBurn = (p.fullGen > 0) ? std::min(p.burnIn, std::max(0, p.gen - p.fullGen)) : 0;
+    return fmt::format("{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}", static_cast<int>(p.loop), p.popsize,
+                       p.mutation, p.recombination, p.mutStep, p.fitVar, p.gamma, p.mutLocus, p.stoch, p.ctrlWt,
+                       p.burnIn, coarseBurn, p.fidScale, p.fidTol, p.ctrlOrder, p.plantOrder, p.polyLoci);
+}
+
+// Run diagnostics in same key = value form as parameters, printed only when used
+
+std::string PrintRunInfo(Param& p, SumStat& stats)
+{
+    std::string outString;
+    std::string format = "{:<10} = {:>9}\n";
+    if (p.fullGen > 0){
+        outString += fmt::format("{:<10} = {:>9.3e}\n", "fidChange", p.fidChange);
+        outString += fmt::format(format, "fidFail", p.fidFail);
+    }
+    if (p.clones > 0){
+        outString += fmt::format(format, "clones", static_cast<int>(p.cloneOn));
+        outString += fmt::format(format, "cloneMax", p.cloneMax);
+        outString += fmt::format("{:<10} = {:>9.1f}\n", "cloneMean", p.cloneMean);
+    }
+    if (p.eqWindow > 0){
+        outString += fmt::format(format, "eqWindow", p.eqWindow);
+        outString += fmt::format("{:<10} = {:>9.3e}\n", "eqTol", p.eqTol);
+        outString += fmt::format(format, "eqGen", p.eqGen);
+    }
+    if (p.degenGen >= 0)
+        outString += fmt::format(format, "degenGen", p.degenGen);
+    if (p.numaNode >= 0){
+        outString += fmt::format(format, "numaNode", p.numaNode);
+        outString += fmt::format(format, "numaPages", p.numaPages);
+        outString += fmt::format(format, "numaRemote", p.numaRemote);
+        outString += fmt::format(format, "numaHugeKB", p.numaHugeKB);
+    }
+    if (p.burnIn > 0){
+        outString += fmt::format(format, "burnIn", p.burnIn);
+        outString += fmt::format(format, "forked", static_cast<int>(p.forked));
+    }
+    if (p.geneal > 0){
+        auto& tmrca = stats.getTMRCA();
+        int coal = 0;
+        double mean = 0.0;
+        for (auto t : tmrca){
+            if (t >= 0){
+                ++coal;
+                mean += t;
+            }
+        }
+        outString += fmt::format(format, "geneal", p.geneal);
+        outString += fmt::format(format, "genNodes", stats.getGenNodes());
+        outString += fmt::format(format, "genEdges", stats.getGenEdges());
+        outString += fmt::format(format, "genMuts", stats.getGenMuts());
+        outString += fmt::format(format, "genCoal", coal);
+        outString += fmt::format("{:<10} = {:>9.1f}\n", "genTMRCA", (coal > 0) ? mean/coal : -1.0);
+    }
+    return outString;
+}
+
 void PrintSummary(Param& param, std::ostringstream& resultss, SumStat& stats)
 {
+    resultss << PrintParam(param) << PrintRunInfo(param, stats) << "\n";
+    PrintStats(param, resultss, stats);
+}
+
+// One summary for replicates of a design point: parameters of first replicate, then statistics as in PrintSummary with mean over replicates of each field, percentiles averaged by rank, then the same layout with variances among replicates and with 95% confidence half widths of the means, -1 if fewer than two replicates. extractData.py reads all three.
+
+std::string PrintAggregate(Param& param, SumStat& mean, SumStat& var, SumStat& half, int n, const std::vector<int>& runs)
+{
+    std::ostringstream resultss;
     resultss << PrintParam(param);
+    resultss << fmt::format("{:<10} = {:>9}\n", "reps", n);
+    std::string list;
+    for (auto r : runs) list += fmt::format(" {}", r);
+    resultss << fmt::format("{:<10} ={}\n\n", "repRuns", list);
+    PrintStats(param, resultss, mean);
+    resultss << "Replicate variances\n\n";
+    PrintStats(param, resultss, var);
+    resultss << "Replicate 95% confidence half widths\n\n";
+    PrintStats(param, resultss, half);
+    return resultss.str();
+}
+
+void PrintStats(Param& param, std::ostringstream& resultss, SumStat& stats)
+{
 
     // print fitness distn
     
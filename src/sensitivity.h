@@ -10,10 +10,27 @@ using rndType = pcgT::result_type;
 extern SAFrand_pcg<pcgT> rnd;
 extern const int linesPerRun;
 extern bool showProgress;
+extern std::string outputTag;   // set by main, used in names of extra output files
+
+// Random numbers by purpose: select parents, vary genotypes by mutation and recombination, perturb phenotypes by aSD and stochWt. Each points to rnd unless pairedStreams, then each is its own generator seeded in LifeCycle from the run seed, so runs with the same seed that differ only in loop type draw common random numbers for each purpose. Set by main.
+struct RndStreams {SAFrand_pcg<pcgT> *select; SAFrand_pcg<pcgT> *vary; SAFrand_pcg<pcgT> *perturb;};
+extern RndStreams rndStreams;
+extern bool pairedStreams;
 
 std::string Control(std::istringstream& parmBuf);
+void        CloseDumps();       // after last run: finish population dump files, rethrow write errors, see PopDump.h
+
+// main outputs of last run, for drivers that choose runs by their results
+struct RunSummary {double aveFitness; double gSD; double lowFitRepeat;};
+RunSummary  LastRunSummary();
 
 #include "typedefs.h"
 #include "util.h"       // includes percentiles, rounding of floats, ThrowError()
 
+// statistics and parameters of last run, for drivers that aggregate replicates, see Aggregate.h
+class SumStat;
+SumStat&    LastRunStats();
+Param&      LastRunParam();
+std::string PrintAggregate(Param& param, SumStat& mean, SumStat& var, SumStat& half, int n, const std::vector<int>& runs);
+
 #endif
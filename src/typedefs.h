@@ -32,6 +32,39 @@ struct Param {
     double gamma;
     Loop loop;
     std::string rec;
+    double tableErr;       // > 0 => tabulate J in single-locus deterministic mode, max interpolation error
+    int    odeMethod;      // step response integration: 0 => native, 1 => GSL, 2 => both, check parity
+    int    geneal;         // > 0 => record genealogy, simplify every geneal generations
+    int    burnIn;         // > 0 => share first burnIn generations among runs that differ only in aSD, stochWt, gen, seed
+    double ctrlWt;         // > 0 => J includes ctrlWt * squared error of control signal
+    int    fullGen;        // > 0 => coarse numerical fidelity except final fullGen generations and stats
+    double fidScale;       // coarse fidelity tolerances = full tolerances * fidScale
+    double fidTol;         // max change of selection probabilities from coarse fidelity, else switch to full
+    double fidChange;      // max measured change, set in LifeCycle
+    int    fidFail;        // generation at which check failed and run switched to full fidelity, -1 if none
+    bool   forked;         // run started from shared burn in population, set in LifeCycle
+    int    clones;         // > 0 => clone class population when fitness deterministic and no genealogy
+    bool   cloneOn;        // clone classes used in this run, set in LifeCycle
+    int    cloneMax;       // max number of classes over generations
+    double cloneMean;      // mean number of classes over generations
+    double surrTol;        // > 0 => surrogate J in multi-locus deterministic mode, max predicted error
+    int    robust;         // > 0 => robustness scan of this many individuals of final population
+    int    freqResp;       // > 0 => frequency response and stability margins of this many individuals of final population
+    int    stepBands;      // > 0 => percentile bands of step response of this many individuals of final population
+    int    ctrlOrder;      // degree of controller numerator, loci = 2 ctrlOrder + 1, + 2 for dclose
+    int    plantOrder;     // degree of plant denominator, see PlantDen
+    int    eqWindow;       // > 0 => stop when fitness mean, SD and allele variance stationary over blocks of eqWindow generations
+    double eqTol;          // max relative change of block means of those statistics beyond 2 standard errors
+    int    selGrad;        // > 0 => selection gradients and curvature from Jet derivatives of this many individuals of final population
+    int    dump;           // > 0 => raw binary file of final population alleles, fitness and J, see PopDump.h
+    int    polyLoci;       // > 1 => polygenic mode, each of loci traits is sum of polyLoci loci, see Individual.h
+    int    eqGen;          // generation at which run stopped at equilibrium, -1 if none, set in LifeCycle
+    int    degenGen;       // generation at which run stopped with degenerate fitness, -1 if none, set in LifeCycle
+    int    numaNode;       // NUMA node of run, -1 if no placement, see Numa.h; set in LifeCycle
+    long   numaPages;      // pages of both populations at end of run
+    long   numaRemote;     // of which on another node
+    long   numaHugeKB;     // anonymous huge pages of process, kB
+
 };
 
 #endif